@@ -0,0 +1,210 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "alloc_stats.h"
+
+#ifdef SKYSCRAPER_ALLOC_STATS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Counters for a single phase.
+struct PhaseCounters {
+  std::atomic<long> allocations{0};
+  std::atomic<long> frees{0};
+  std::atomic<long> bytes{0};
+  std::atomic<long> live_bytes{0};
+  std::atomic<long> peak_live_bytes{0};
+};
+
+PhaseCounters counters[static_cast<int>(AllocPhase::COUNT)];
+std::atomic<long> total_live_bytes{0};
+std::atomic<long> total_peak_live_bytes{0};
+
+thread_local AllocPhase current_phase = AllocPhase::OTHER;
+
+const char* const PHASE_NAMES[] = {
+  "other", "generation", "validation", "clues", "solving", "output",
+};
+
+// Every block starts with a header that records its size and the
+// phase that allocated it, so that frees can be attributed too.
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) Header {
+  size_t size;
+  AllocPhase phase;
+};
+constexpr size_t HEADER_SIZE = sizeof(Header);
+
+void update_peak(std::atomic<long>& peak, const long value) {
+  long current = peak.load(std::memory_order_relaxed);
+  while (value > current &&
+         !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+void record_allocation(Header* header, const size_t size) {
+  header->size = size;
+  header->phase = current_phase;
+  PhaseCounters& c = counters[static_cast<int>(header->phase)];
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+  c.bytes.fetch_add(size, std::memory_order_relaxed);
+  update_peak(c.peak_live_bytes, c.live_bytes.fetch_add(size, std::memory_order_relaxed) + size);
+  update_peak(total_peak_live_bytes,
+              total_live_bytes.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+void record_free(const Header* header) {
+  PhaseCounters& c = counters[static_cast<int>(header->phase)];
+  c.frees.fetch_add(1, std::memory_order_relaxed);
+  c.live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+  total_live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+}
+
+// For over-aligned blocks, the header sits right before the returned
+// pointer, and the padding in front of it depends on the alignment.
+size_t prefix_size(const std::align_val_t alignment) {
+  const size_t a = static_cast<size_t>(alignment);
+  return a > HEADER_SIZE ? a : HEADER_SIZE;
+}
+
+void* allocate(const size_t size) {
+  void* raw = std::malloc(size + HEADER_SIZE);
+  if (raw == nullptr)
+    return nullptr;
+  Header* header = static_cast<Header*>(raw);
+  record_allocation(header, size);
+  return header + 1;
+}
+
+void deallocate(void* p) {
+  if (p == nullptr)
+    return;
+  Header* header = static_cast<Header*>(p) - 1;
+  record_free(header);
+  std::free(header);
+}
+
+void* allocate_aligned(const size_t size, const std::align_val_t alignment) {
+  const size_t prefix = prefix_size(alignment);
+  const size_t a = static_cast<size_t>(alignment);
+  // aligned_alloc() wants a multiple of the alignment.
+  const size_t total = (size + prefix + a - 1) / a * a;
+  char* raw = static_cast<char*>(std::aligned_alloc(a, total));
+  if (raw == nullptr)
+    return nullptr;
+  Header* header = reinterpret_cast<Header*>(raw + prefix) - 1;
+  record_allocation(header, size);
+  return raw + prefix;
+}
+
+void deallocate_aligned(void* p, const std::align_val_t alignment) {
+  if (p == nullptr)
+    return;
+  record_free(static_cast<Header*>(p) - 1);
+  std::free(static_cast<char*>(p) - prefix_size(alignment));
+}
+
+void* allocate_or_throw(const size_t size) {
+  void* p = allocate(size);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* allocate_aligned_or_throw(const size_t size, const std::align_val_t alignment) {
+  void* p = allocate_aligned(size, alignment);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void print_report() {
+  // Avoid iostreams here: they may already be gone, and they allocate.
+  std::fprintf(stderr, "Allocation statistics:\n");
+  std::fprintf(stderr, "  %-12s %14s %14s %18s %18s\n",
+               "phase", "allocations", "frees", "bytes", "peak live bytes");
+  for (int i = 0; i < static_cast<int>(AllocPhase::COUNT); ++i) {
+    const PhaseCounters& c = counters[i];
+    std::fprintf(stderr, "  %-12s %14ld %14ld %18ld %18ld\n", PHASE_NAMES[i],
+                 c.allocations.load(), c.frees.load(), c.bytes.load(), c.peak_live_bytes.load());
+  }
+  std::fprintf(stderr, "  peak live bytes overall: %ld\n", total_peak_live_bytes.load());
+}
+
+// Registers the report as soon as the program starts.
+struct ReportAtExit {
+  ReportAtExit() { std::atexit(print_report); }
+} report_at_exit;
+
+}  // namespace
+
+AllocPhaseScope::AllocPhaseScope(const AllocPhase phase) : previous_(current_phase) {
+  current_phase = phase;
+}
+
+AllocPhaseScope::~AllocPhaseScope() {
+  current_phase = previous_;
+}
+
+void* operator new(size_t size) { return allocate_or_throw(size); }
+void* operator new[](size_t size) { return allocate_or_throw(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) {
+  return allocate_aligned_or_throw(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return allocate_aligned_or_throw(size, alignment);
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return allocate_aligned(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept { deallocate(p); }
+void operator delete[](void* p) noexcept { deallocate(p); }
+void operator delete(void* p, size_t) noexcept { deallocate(p); }
+void operator delete[](void* p, size_t) noexcept { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { deallocate(p); }
+void operator delete(void* p, std::align_val_t alignment) noexcept {
+  deallocate_aligned(p, alignment);
+}
+void operator delete[](void* p, std::align_val_t alignment) noexcept {
+  deallocate_aligned(p, alignment);
+}
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept {
+  deallocate_aligned(p, alignment);
+}
+void operator delete[](void* p, size_t, std::align_val_t alignment) noexcept {
+  deallocate_aligned(p, alignment);
+}
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  deallocate_aligned(p, alignment);
+}
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  deallocate_aligned(p, alignment);
+}
+
+#endif
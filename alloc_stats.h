@@ -0,0 +1,66 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+// Heap allocation accounting, enabled by building with
+// -DSKYSCRAPER_ALLOC_STATS=ON. In that build, the global operator
+// new and delete are replaced with versions that count allocations,
+// bytes and peak live bytes for the phase that the calling thread is
+// in, and a report is printed to stderr on exit. In regular builds,
+// everything here compiles to nothing.
+
+// The phases that allocations are attributed to.
+enum class AllocPhase {
+  OTHER = 0,
+  GENERATION,
+  VALIDATION,
+  CLUES,
+  SOLVING,
+  OUTPUT,
+  // Not a phase: the number of phases.
+  COUNT,
+};
+
+#ifdef SKYSCRAPER_ALLOC_STATS
+
+// Attributes the allocations made by the current thread to `phase`,
+// for as long as this object lives. Scopes can be nested.
+class AllocPhaseScope {
+ public:
+  explicit AllocPhaseScope(const AllocPhase phase);
+  ~AllocPhaseScope();
+
+  AllocPhaseScope(const AllocPhaseScope&) = delete;
+  AllocPhaseScope& operator=(const AllocPhaseScope&) = delete;
+
+ private:
+  const AllocPhase previous_;
+};
+
+#else
+
+class AllocPhaseScope {
+ public:
+  explicit AllocPhaseScope(const AllocPhase) {}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "create.h"
+#include "options.h"
+
+namespace {
+
+// A benchmark workload: `boards` boards of the given mode and size,
+// using seeds `seed` through `seed + boards - 1`. The counts are sized
+// so that each pass takes about a quarter of a second.
+struct Workload {
+  const char* name;
+  CreateMode mode;
+  uint16_t size;
+  int boards;
+  uint32_t seed;
+};
+
+// The workload matrix. Changing it invalidates saved baselines for
+// the affected entries.
+constexpr Workload WORKLOADS[] = {
+  {"shuffle-5",  CreateMode::SHUFFLE,  5,   35, 1},
+  {"shuffle-9",  CreateMode::SHUFFLE,  9,   30, 1},
+  {"shuffle-16", CreateMode::SHUFFLE, 16,   30, 1},
+  {"random-5",   CreateMode::RANDOM,   5, 5000, 1},
+  {"random-9",   CreateMode::RANDOM,   9, 2000, 1},
+  {"random-16",  CreateMode::RANDOM,  16,  400, 1},
+  {"dlx-9",      CreateMode::DLX,      9, 2000, 1},
+  {"dlx-16",     CreateMode::DLX,     16,  400, 1},
+};
+
+// Every workload runs once to warm up the caches and the allocator,
+// then this many times for the figures. Comparisons use the medians
+// over the measured passes, which a single slow pass does not move.
+constexpr int WARMUP_PASSES = 1;
+constexpr int MEASURED_PASSES = 5;
+
+struct Result {
+  const Workload* workload;
+  // The median pass.
+  double seconds;
+  double puzzles_per_second;
+  // Latency percentiles over the boards of all the measured passes.
+  double p50_ms;
+  double p99_ms;
+};
+
+// The figures of a workload in a previous run.
+struct Baseline {
+  double puzzles_per_second;
+  double p50_ms;
+};
+
+// Returns the nearest-rank percentile of sorted samples.
+double percentile(const std::vector<double>& sorted, const double p) {
+  const size_t rank = std::ceil(p / 100 * sorted.size());
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+long peak_rss_kb() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  // On Linux, ru_maxrss is in kilobytes.
+  return usage.ru_maxrss;
+}
+
+// Creates every board of a workload once, appending their latencies
+// to `latencies_ms` if it is not null. Returns the elapsed seconds, or
+// nothing if a board failed.
+std::optional<double> run_pass(const Workload& workload, std::vector<double>* latencies_ms) {
+  // Each board goes through the whole create path, including output;
+  // only the destination is discarded.
+  ProgramOptions options;
+  options.mode = ProgramMode::CREATE;
+  options.board_size = workload.size;
+  options.puzzle_output_file = "/dev/null";
+  options.board_output_file = "/dev/null";
+  options.create_options.mode = workload.mode;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < workload.boards; ++i) {
+    options.create_options.seed = workload.seed + i;
+    const auto board_start = std::chrono::steady_clock::now();
+    if (create_board(options) != EXIT_SUCCESS) {
+      std::cerr << "ERROR: workload " << workload.name << " failed with seed "
+                << options.create_options.seed << std::endl;
+      return std::nullopt;
+    }
+    const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - board_start;
+    if (latencies_ms != nullptr)
+      latencies_ms->push_back(elapsed.count());
+  }
+  const std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+  return total.count();
+}
+
+std::optional<Result> run_workload(const Workload& workload) {
+  for (int i = 0; i < WARMUP_PASSES; ++i) {
+    if (!run_pass(workload, nullptr).has_value())
+      return std::nullopt;
+  }
+
+  std::vector<double> pass_seconds;
+  std::vector<double> latencies_ms;
+  latencies_ms.reserve(size_t(MEASURED_PASSES) * workload.boards);
+  for (int i = 0; i < MEASURED_PASSES; ++i) {
+    const std::optional<double> seconds = run_pass(workload, &latencies_ms);
+    if (!seconds.has_value())
+      return std::nullopt;
+    pass_seconds.push_back(*seconds);
+  }
+
+  std::sort(pass_seconds.begin(), pass_seconds.end());
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  const double median_seconds = percentile(pass_seconds, 50);
+  return Result{.workload = &workload,
+                .seconds = median_seconds,
+                .puzzles_per_second = workload.boards / median_seconds,
+                .p50_ms = percentile(latencies_ms, 50),
+                .p99_ms = percentile(latencies_ms, 99)};
+}
+
+// Extracts the number following `"key":` in `text`, starting at
+// `from` and stopping at `to`.
+std::optional<double> find_number(const std::string& text, const std::string& key,
+                                  const size_t from, const size_t to) {
+  const size_t position = text.find("\"" + key + "\":", from);
+  if (position == std::string::npos || position >= to)
+    return std::nullopt;
+  const char* start = text.c_str() + position + key.size() + 3;
+  char* end = nullptr;
+  const double value = strtod(start, &end);
+  if (end == start)
+    return std::nullopt;
+  return value;
+}
+
+// Finds a workload in the output of a previous run. The format is the
+// one written by run_benchmark(), with one workload per line.
+std::optional<Baseline> find_baseline(const std::string& text, const char* name) {
+  const size_t position = text.find("\"name\": \"" + std::string(name) + "\"");
+  if (position == std::string::npos)
+    return std::nullopt;
+  const size_t end = text.find('}', position);
+  const std::optional<double> per_second = find_number(text, "puzzles_per_second", position, end);
+  const std::optional<double> p50 = find_number(text, "p50_ms", position, end);
+  if (!per_second.has_value() || !p50.has_value())
+    return std::nullopt;
+  return Baseline{*per_second, *p50};
+}
+
+}  // namespace
+
+int run_benchmark(const ProgramOptions& options) {
+  const BenchOptions& bench_options = options.bench_options;
+
+  std::string baseline_text;
+  if (bench_options.baseline_file != nullptr) {
+    std::ifstream in{bench_options.baseline_file};
+    if (!in) {
+      std::cerr << "ERROR: cannot read baseline file: " << bench_options.baseline_file << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    baseline_text = buffer.str();
+  }
+
+  std::vector<Result> results;
+  for (const Workload& workload : WORKLOADS) {
+    std::cerr << "Running workload " << workload.name << "..." << std::endl;
+    std::optional<Result> result = run_workload(workload);
+    if (!result.has_value())
+      return EXIT_FAILURE;
+    results.push_back(*result);
+  }
+
+  const double threshold = bench_options.threshold_percent / 100;
+  int regressions = 0;
+  std::ofstream out{options.puzzle_output_file, std::ios::out};
+  out << std::fixed << std::setprecision(3);
+  out << "{" << std::endl << "  \"workloads\": [" << std::endl;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    const Workload& w = *r.workload;
+    out << "    {\"name\": \"" << w.name << "\", \"mode\": \"" << create_mode_name(w.mode)
+        << "\", \"size\": " << w.size << ", \"boards\": " << w.boards
+        << ", \"seed\": " << w.seed << ", \"passes\": " << MEASURED_PASSES
+        << ", \"seconds\": " << r.seconds
+        << ", \"puzzles_per_second\": " << r.puzzles_per_second
+        << ", \"p50_ms\": " << r.p50_ms << ", \"p99_ms\": " << r.p99_ms;
+
+    if (bench_options.baseline_file != nullptr) {
+      const std::optional<Baseline> baseline = find_baseline(baseline_text, w.name);
+      if (baseline.has_value()) {
+        const bool regressed =
+          r.puzzles_per_second < baseline->puzzles_per_second * (1 - threshold) ||
+          r.p50_ms > baseline->p50_ms * (1 + threshold);
+        out << ", \"baseline_puzzles_per_second\": " << baseline->puzzles_per_second
+            << ", \"baseline_p50_ms\": " << baseline->p50_ms
+            << ", \"regression\": " << (regressed ? "true" : "false");
+        if (regressed) {
+          ++regressions;
+          std::cerr << "REGRESSION: " << w.name << ": " << r.puzzles_per_second
+                    << " puzzles/s (baseline " << baseline->puzzles_per_second << "), p50 "
+                    << r.p50_ms << " ms (baseline " << baseline->p50_ms << ")" << std::endl;
+        }
+      } else {
+        std::cerr << "WARNING: workload " << w.name << " not found in the baseline" << std::endl;
+      }
+    }
+    out << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+  }
+  // ru_maxrss only ever grows, so it is reported once, for the whole
+  // run, instead of per workload.
+  out << "  ]," << std::endl << "  \"peak_rss_kb\": " << peak_rss_kb() << "," << std::endl
+      << "  \"regressions\": " << regressions << std::endl << "}" << std::endl;
+
+  return regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "options.h"
+
+// Runs a fixed matrix of creation workloads, with fixed seeds, and
+// prints their throughput and latency percentiles, and the peak
+// memory usage of the run, as JSON. Each workload is warmed up, then
+// measured over several passes. If a baseline file is given, also
+// compares the medians of each workload with it and reports
+// regressions. Returns a value compatible with
+// 'man 3 exit', which is a failure if any regression was found.
+int run_benchmark(const ProgramOptions& options);
+
+#endif
@@ -0,0 +1,258 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "bitboard.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+constexpr uint64_t LOW_BITS = 0x0101010101010101ULL;   // column 0 of every row
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;  // column 7 of every row
+
+// Returns a mask with the lowest `count` bits set.
+uint64_t low_mask(const int count) {
+  return count >= 64 ? ~0ULL : (1ULL << count) - 1;
+}
+
+// Returns the bits of the cells in the first `size` rows and columns.
+uint64_t board_mask(const int size) {
+  return low_mask(8 * size) & (LOW_BITS * low_mask(size));
+}
+
+// Sets the top bit of every byte of `x` that is not zero, and clears
+// all the others.
+uint64_t nonzero_bytes(const uint64_t x) {
+  return (((x & ~HIGH_BITS) + ~HIGH_BITS) | x) & HIGH_BITS;
+}
+
+// Sets, within every byte, all the bits above its lowest set bit.
+uint64_t fill_up(uint64_t x) {
+  x |= (x << 1) & 0xfefefefefefefefeULL;
+  x |= (x << 2) & 0xfcfcfcfcfcfcfcfcULL;
+  x |= (x << 4) & 0xf0f0f0f0f0f0f0f0ULL;
+  return x;
+}
+
+// Sets, within every byte, all the bits below its highest set bit.
+uint64_t fill_down(uint64_t x) {
+  x |= (x >> 1) & 0x7f7f7f7f7f7f7f7fULL;
+  x |= (x >> 2) & 0x3f3f3f3f3f3f3f3fULL;
+  x |= (x >> 4) & 0x0f0f0f0f0f0f0f0fULL;
+  return x;
+}
+
+// Mirrors an 8x8 bit matrix along its main diagonal.
+uint64_t transpose(uint64_t x) {
+  uint64_t t = 0x0f0f0f0f00000000ULL & (x ^ (x << 28));
+  x ^= t ^ (t >> 28);
+  t = 0x3333000033330000ULL & (x ^ (x << 14));
+  x ^= t ^ (t >> 14);
+  t = 0x5500550055005500ULL & (x ^ (x << 7));
+  x ^= t ^ (t >> 7);
+  return x;
+}
+
+// Swaps the bits selected by `mask` when shifted by `first` with the
+// ones selected by it when shifted by `second`.
+uint64_t swap_bits(const uint64_t x, const uint64_t mask, const int first, const int second) {
+  const uint64_t delta = ((x >> first) ^ (x >> second)) & mask;
+  return x ^ (delta << first) ^ (delta << second);
+}
+
+// Counts, for all rows at once, the buildings visible from the left
+// (`from_left`) and from the right (`from_right`). Byte r of each
+// result holds the count for row r.
+void count_visible(const uint64_t* planes, const int size, uint64_t* from_left,
+                   uint64_t* from_right) {
+  uint64_t left = 0;
+  uint64_t right = 0;
+  // The cells of the buildings taller than the current value.
+  uint64_t taller = 0;
+  for (int value = size; value >= 1; --value) {
+    const uint64_t plane = planes[value - 1];
+    // A building is visible if no taller one stands between it and
+    // the side.
+    left += nonzero_bytes(plane & ~fill_up(taller)) >> 7;
+    right += nonzero_bytes(plane & ~fill_down(taller)) >> 7;
+    taller |= plane;
+  }
+  *from_left = left;
+  *from_right = right;
+}
+
+}  // namespace
+
+BitBoard::BitBoard(const int size) : size_(size), planes_{} {
+  if (size_ <= 0 || size_ > MAX_BITBOARD_SIZE) {
+    std::cerr << "Bad bitboard size: " << size_ << std::endl;
+    std::abort();
+  }
+}
+
+std::optional<BitBoard> BitBoard::from_board(const Board& board) {
+  if (board.size() > MAX_BITBOARD_SIZE)
+    return std::nullopt;
+  BitBoard result{board.size()};
+  for (int row = 0; row < board.size(); ++row) {
+    for (int column = 0; column < board.size(); ++column) {
+      const int value = board.at(row, column);
+      if (value != 0)
+        result.planes_[value - 1] |= 1ULL << (8 * row + column);
+    }
+  }
+  return result;
+}
+
+void BitBoard::copy_to(Board& board) const {
+  if (board.size() != size_) {
+    std::cerr << "FATAL: copying a bitboard of size " << size_ << " to a board of size "
+              << board.size() << ". This should never happen." << std::endl;
+    std::abort();
+  }
+  for (int row = 0; row < size_; ++row) {
+    for (int column = 0; column < size_; ++column) {
+      const int value = at(row, column);
+      if (value == 0)
+        board.clear(row, column);
+      else
+        board.set(value, row, column);
+    }
+  }
+}
+
+int BitBoard::at(const int row, const int column) const {
+  if (row < 0 || row >= size_ || column < 0 || column >= size_) {
+    std::cerr << "Bad access at {" << row << ", " << column << "}" << std::endl;
+    std::abort();
+  }
+
+  const uint64_t bit = 1ULL << (8 * row + column);
+  for (int value = 1; value <= size_; ++value) {
+    if (planes_[value - 1] & bit)
+      return value;
+  }
+  return 0;
+}
+
+bool BitBoard::set(const int value, const int row, const int column) {
+  if (value < 1 || value > size_) {
+    std::cerr << "Attempted to write bad value: " << value << std::endl;
+    return false;
+  }
+  clear(row, column);
+  planes_[value - 1] |= 1ULL << (8 * row + column);
+  return true;
+}
+
+void BitBoard::clear(const int row, const int column) {
+  if (row < 0 || row >= size_ || column < 0 || column >= size_) {
+    std::cerr << "Bad access at {" << row << ", " << column << "}" << std::endl;
+    std::abort();
+  }
+
+  const uint64_t bit = 1ULL << (8 * row + column);
+  for (uint64_t& plane : planes_)
+    plane &= ~bit;
+}
+
+// Each cell holds at most one value, so a line of `size` cells is
+// valid exactly when every value appears somewhere in it.
+
+bool BitBoard::is_row_valid(const int row) const {
+  if (row < 0 || row >= size_)
+    return false;
+  for (int value = 1; value <= size_; ++value) {
+    if (((planes_[value - 1] >> (8 * row)) & 0xff) == 0)
+      return false;
+  }
+  return true;
+}
+
+bool BitBoard::is_column_valid(const int column) const {
+  if (column < 0 || column >= size_)
+    return false;
+  for (int value = 1; value <= size_; ++value) {
+    if (((planes_[value - 1] >> column) & LOW_BITS) == 0)
+      return false;
+  }
+  return true;
+}
+
+bool BitBoard::is_valid() const {
+  const uint64_t rows = nonzero_bytes(board_mask(size_));
+  const uint64_t columns = low_mask(size_);
+  for (int value = 1; value <= size_; ++value) {
+    uint64_t plane = planes_[value - 1];
+    // Every row must have the value.
+    if (nonzero_bytes(plane) != rows)
+      return false;
+    // So must every column: fold all the rows onto the first one.
+    plane |= plane >> 32;
+    plane |= plane >> 16;
+    plane |= plane >> 8;
+    if ((plane & 0xff) != columns)
+      return false;
+  }
+  return true;
+}
+
+bool BitBoard::swap_rows(const int first, const int second) {
+  if (first < 0 || first >= size_ || second < 0 || second >= size_)
+    return false;
+  for (int value = 1; value <= size_; ++value)
+    planes_[value - 1] = swap_bits(planes_[value - 1], 0xff, 8 * first, 8 * second);
+  return true;
+}
+
+bool BitBoard::swap_columns(const int first, const int second) {
+  if (first < 0 || first >= size_ || second < 0 || second >= size_)
+    return false;
+  for (int value = 1; value <= size_; ++value)
+    planes_[value - 1] = swap_bits(planes_[value - 1], LOW_BITS, first, second);
+  return true;
+}
+
+BitBoard BitBoard::transposed() const {
+  BitBoard result{size_};
+  for (int value = 1; value <= size_; ++value)
+    result.planes_[value - 1] = transpose(planes_[value - 1]);
+  return result;
+}
+
+void BitBoard::compute_clues(int* clues) const {
+  uint64_t top, bottom, left, right;
+  count_visible(transposed().planes_, size_, &top, &bottom);
+  count_visible(planes_, size_, &left, &right);
+  for (int i = 0; i < size_; ++i) {
+    clues[i] = (top >> (8 * i)) & 0xff;
+    clues[size_ + i] = (bottom >> (8 * i)) & 0xff;
+    clues[2 * size_ + i] = (left >> (8 * i)) & 0xff;
+    clues[3 * size_ + i] = (right >> (8 * i)) & 0xff;
+  }
+}
+
+uint64_t BitBoard::hash() const {
+  uint64_t hash = size_;
+  for (int value = 1; value <= size_; ++value) {
+    hash ^= planes_[value - 1] + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash *= 0xff51afd7ed558ccdULL;
+  }
+  return hash ^ (hash >> 33);
+}
@@ -0,0 +1,77 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include <optional>
+
+#include "board.h"
+
+// The largest board size that fits a bitboard.
+constexpr int MAX_BITBOARD_SIZE = 8;
+
+// A board of at most MAX_BITBOARD_SIZE rows and columns, stored as one
+// 64-bit plane per value: bit `8 * row + column` of the plane of value
+// v is set if that cell holds v. Each row is a byte of every plane, so
+// row and column operations are a few masked shifts, and copying or
+// hashing a board touches only MAX_BITBOARD_SIZE words.
+class BitBoard {
+ public:
+  // Builds an empty board with `size` rows and `size` columns.
+  explicit BitBoard(const int size);
+
+  // Converts a general board. Returns nothing if it is too large.
+  static std::optional<BitBoard> from_board(const Board& board);
+
+  // Overwrites all cells of `board`, which must have the same size.
+  void copy_to(Board& board) const;
+
+  int size() const { return size_; }
+
+  // Same as the `Board` methods of the same name.
+  int at(const int row, const int column) const;
+  bool set(const int value, const int row, const int column);
+  void clear(const int row, const int column);
+  bool is_valid() const;
+  bool is_row_valid(const int row) const;
+  bool is_column_valid(const int column) const;
+  bool swap_rows(const int first, const int second);
+  bool swap_columns(const int first, const int second);
+
+  // Returns the board mirrored along its main diagonal.
+  BitBoard transposed() const;
+
+  // Computes the clues of a valid board, with the layout of
+  // `compute_clues()`.
+  void compute_clues(int* clues) const;
+
+  // A hash of the size and cells.
+  uint64_t hash() const;
+
+  bool operator==(const BitBoard& other) const = default;
+
+ private:
+  int size_;
+  // The plane of value v is at index v - 1. Planes past the size are
+  // always empty.
+  uint64_t planes_[MAX_BITBOARD_SIZE];
+};
+
+#endif
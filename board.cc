@@ -18,12 +18,16 @@
 
 #include "board.h"
 
-#include <cmath>
+#include <algorithm>
 #include <cstdlib>
-#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <unordered_set>
 
+#include "alloc_stats.h"
+#include "text_format.h"
+
 Board::Board(const int size) : Board(size, BoardInitializer::EMPTY) {}
 
 Board::Board(const int size, const BoardInitializer initializer)
@@ -33,20 +37,20 @@ Board::Board(const int size, const BoardInitializer initializer)
     std::abort();
   }
 
-  board_.resize(size_);
-  for (int i = 0; i < size_; ++i) {
-    board_[i].resize(size_);
-  }
+  cells_.resize(size_t(size_) * size_);
+  reset(initializer);
+}
 
+void Board::reset(const BoardInitializer initializer) {
   switch (initializer) {
   case BoardInitializer::EMPTY:
-    // Do nothing.
+    std::fill(cells_.begin(), cells_.end(), 0);
     break;
   case BoardInitializer::DIAGONAL_INCREASING:
     for (int row = 0; row < size_; ++row) {
       for (int column = 0; column < size_; ++column) {
         int value = (size_ + column - row) % size_ + 1;
-        board_[row][column] = value;
+        cells_[index(row, column)] = value;
       }
     }
     break;
@@ -54,12 +58,12 @@ Board::Board(const int size, const BoardInitializer initializer)
 }
 
 int Board::at(const int row, const int column) const {
-  if (row < 0 || row >= size_ || row < 0 || row >= size_) {
+  if (row < 0 || row >= size_ || column < 0 || column >= size_) {
     std::cerr << "Bad access at {" << row << ", " << column << "}" << std::endl;
     std::abort();
   }
 
-  return board_[row][column];
+  return cells_[index(row, column)];
 }
 
 bool Board::set(const int value, const int row, const int column) {
@@ -67,22 +71,22 @@ bool Board::set(const int value, const int row, const int column) {
     std::cerr << "Attempted to write bad value: " << value << std::endl;
     return false;
   }
-  if (row < 0 || row >= size_ || row < 0 || row >= size_) {
+  if (row < 0 || row >= size_ || column < 0 || column >= size_) {
     std::cerr << "Bad access at {" << row << ", " << column << "}" << std::endl;
     std::abort();
   }
 
-  board_[row][column] = value;
+  cells_[index(row, column)] = value;
   return true;
 }
 
 void Board::clear(const int row, const int column) {
-  if (row < 0 || row >= size_ || row < 0 || row >= size_) {
+  if (row < 0 || row >= size_ || column < 0 || column >= size_) {
     std::cerr << "Bad access at {" << row << ", " << column << "}" << std::endl;
     std::abort();
   }
 
-  board_[row][column] = 0;
+  cells_[index(row, column)] = 0;
 }
 
 bool Board::is_row_valid(const int row) const {
@@ -90,6 +94,7 @@ bool Board::is_row_valid(const int row) const {
     return false;
   }
 
+  AllocPhaseScope alloc_phase{AllocPhase::VALIDATION};
   std::unordered_set<int> expected;
   for (int i = 1; i <= size_; ++i)
     expected.insert(i);
@@ -106,6 +111,7 @@ bool Board::is_column_valid(const int column) const {
     return false;
   }
 
+  AllocPhaseScope alloc_phase{AllocPhase::VALIDATION};
   std::unordered_set<int> expected;
   for (int i = 1; i <= size_; ++i)
     expected.insert(i);
@@ -132,15 +138,9 @@ bool Board::is_valid() const {
 }
 
 void Board::print(std::ostream &ostream) const {
-  // Define how many digits are required, at max, to print each value in this board.
-  const int value_width = std::floor(std::log10(size_)) + 1;
-
-  for (int row = 0; row < size_; ++row) {
-    for (int column = 0; column < size_; ++column) {
-      ostream << std::setw(value_width) << board_[row][column] << " ";
-    }
-    ostream << std::endl;
-  }
+  TextFormatter formatter;
+  formatter.append(*this);
+  formatter.write(ostream);
 }
 
 bool Board::swap_rows(const int first, const int second) {
@@ -154,7 +154,8 @@ bool Board::swap_rows(const int first, const int second) {
     return true;
   }
 
-  board_[first].swap(board_[second]);
+  std::swap_ranges(cells_.begin() + index(first, 0), cells_.begin() + index(first + 1, 0),
+                   cells_.begin() + index(second, 0));
   return true;
 }
 
@@ -169,82 +170,176 @@ bool Board::swap_columns(const int first, const int second) {
     return true;
   }
 
-  for (int row = 0; row < size_; ++row) {
-    int tmp = board_[row][first];
-    board_[row][first] = board_[row][second];
-    board_[row][second] = tmp;
-  }
+  for (int row = 0; row < size_; ++row)
+    std::swap(cells_[index(row, first)], cells_[index(row, second)]);
   return true;
 }
 
 RowIterator Board::row_cbegin(const int row) const {
   if (row < 0 || row >= size_) {
     // For invalid accesses, return a zero-length row.
-    return board_[0].cend();
+    return cells_.cend();
   }
 
-  return board_[row].cbegin();
+  return cells_.cbegin() + index(row, 0);
 }
 
 RowIterator Board::row_cend(const int row) const {
   if (row < 0 || row >= size_) {
     // For invalid accesses, return a zero-length row.
-    return board_[0].cend();
+    return cells_.cend();
   }
 
-  return board_[row].cend();
+  return cells_.cbegin() + index(row + 1, 0);
 }
 
 ReverseRowIterator Board::row_crbegin(const int row) const {
-  if (row < 0 || row >= size_) {
-    // For invalid accesses, return a zero-length row.
-    return board_[0].crend();
-  }
-
-  return board_[row].crbegin();
+  return ReverseRowIterator(row_cend(row));
 }
 
 ReverseRowIterator Board::row_crend(const int row) const {
-  if (row < 0 || row >= size_) {
-    // For invalid accesses, return a zero-length row.
-    return board_[0].crend();
-  }
-
-  return board_[row].crend();
+  return ReverseRowIterator(row_cbegin(row));
 }
 
 ColumnIterator Board::column_cbegin(const int column) const {
   if (column < 0 || column >= size_) {
     // For invalid accesses, return a zero-length column.
-    return ColumnIterator(*this, 0, size_);
+    return ColumnIterator(cells_.data(), size_, 0, 0);
   }
 
-  return ColumnIterator(*this, column, 0);
+  return ColumnIterator(cells_.data() + column, size_, 0, size_);
 }
 
 ColumnIterator Board::column_cend(const int column) const {
   if (column < 0 || column >= size_) {
     // For invalid accesses, return a zero-length column.
-    return ColumnIterator(*this, 0, size_);
+    return ColumnIterator(cells_.data(), size_, 0, 0);
   }
 
-  return ColumnIterator(*this, column, size_);
+  return ColumnIterator(cells_.data() + column, size_, size_, size_);
 }
 
 ReverseColumnIterator Board::column_crbegin(const int column) const {
-  if (column < 0 || column >= size_) {
-    // For invalid accesses, return a zero-length column.
-    return ReverseColumnIterator(*this, 0, -1);
+  return ReverseColumnIterator(column_cend(column));
+}
+
+ReverseColumnIterator Board::column_crend(const int column) const {
+  return ReverseColumnIterator(column_cbegin(column));
+}
+
+RowSpan Board::row(const int row) const {
+  return RowSpan(row_cbegin(row), row_cend(row));
+}
+
+ColumnSpan Board::column(const int column) const {
+  return ColumnSpan(column_cbegin(column), column_cend(column));
+}
+
+std::optional<Board> parse_board(std::istream& istream) {
+  // Skip blank lines before the board.
+  std::string line;
+  while (std::getline(istream, line) && line.find_first_not_of(" \t\r") == std::string::npos) {}
+
+  std::vector<int> values;
+  std::istringstream first_row{line};
+  for (int value; first_row >> value;)
+    values.push_back(value);
+  if (!first_row.eof() || values.empty())
+    return std::nullopt;
+
+  const int size = values.size();
+  for (int row = 1; row < size; ++row) {
+    for (int column = 0; column < size; ++column) {
+      int value;
+      if (!(istream >> value))
+        return std::nullopt;
+      values.push_back(value);
+    }
   }
 
-  return ReverseColumnIterator(*this, column, size_ - 1);
+  Board b{size};
+  for (int i = 0; i < size * size; ++i) {
+    if (values[i] < 0 || values[i] > size)
+      return std::nullopt;
+    if (values[i] != 0)
+      b.set(values[i], i / size, i % size);
+  }
+  return b;
 }
 
-ReverseColumnIterator Board::column_crend(const int column) const {
-  if (column < 0 || column >= size_) {
-    // For invalid accesses, return a zero-length column.
-    return ReverseColumnIterator(*this, 0, -1);
+namespace {
+
+// Tries to give `cell` one of its candidate values, moving the cells
+// that already hold one along an augmenting path (Kuhn's algorithm).
+// `owner[v]` is the cell holding value v, or -1.
+bool augment(const int cell, const std::vector<std::vector<int>>& candidates,
+             std::vector<int>& owner, std::vector<char>& visited) {
+  for (const int value : candidates[cell]) {
+    if (visited[value])
+      continue;
+    visited[value] = true;
+    if (owner[value] < 0 || augment(owner[value], candidates, owner, visited)) {
+      owner[value] = cell;
+      return true;
+    }
   }
+  return false;
+}
 
-  return ReverseColumnIterator(*this, column, -1);
+// Returns whether every cell can get a different one of its candidate
+// values, all of them at most `max_value`.
+bool has_matching(const std::vector<std::vector<int>>& candidates, const int max_value) {
+  std::vector<int> owner(max_value + 1, -1);
+  std::vector<char> visited(max_value + 1);
+  for (size_t cell = 0; cell < candidates.size(); ++cell) {
+    std::fill(visited.begin(), visited.end(), false);
+    if (!augment(cell, candidates, owner, visited))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool is_partial_board_feasible(const Board& partial) {
+  const int size = partial.size();
+  // Whether each row and column already holds each value.
+  const size_t stride = size + 1;
+  std::vector<char> in_row(size * stride);
+  std::vector<char> in_column(size * stride);
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column) {
+      const int value = partial.at(row, column);
+      if (value == 0)
+        continue;
+      if (in_row[row * stride + value] || in_column[column * stride + value])
+        return false;
+      in_row[row * stride + value] = true;
+      in_column[column * stride + value] = true;
+    }
+  }
+
+  // Match the free cells of each line with the values it misses.
+  std::vector<std::vector<int>> candidates;
+  for (int line = 0; line < size; ++line) {
+    for (const bool is_row : {true, false}) {
+      candidates.clear();
+      for (int i = 0; i < size; ++i) {
+        const int row = is_row ? line : i;
+        const int column = is_row ? i : line;
+        if (partial.at(row, column) != 0)
+          continue;
+        std::vector<int>& values = candidates.emplace_back();
+        for (int value = 1; value <= size; ++value) {
+          if (!in_row[row * stride + value] && !in_column[column * stride + value])
+            values.push_back(value);
+        }
+        if (values.empty())
+          return false;
+      }
+      if (!has_matching(candidates, size))
+        return false;
+    }
+  }
+  return true;
 }
@@ -19,7 +19,9 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <cstddef>
 #include <iostream>
+#include <optional>
 #include <vector>
 
 #include "board_iterators.h"
@@ -43,6 +45,10 @@ class Board {
   // contents specified by the initializer.
   Board(const int size, const BoardInitializer initializer);
 
+  // Overwrites all cells with the contents specified by the
+  // initializer, keeping the size.
+  void reset(const BoardInitializer initializer);
+
   // Retrieves the board size.
   int size() const { return size_; }
 
@@ -74,6 +80,9 @@ class Board {
   // Prints the board to the provided output stream.
   void print(std::ostream &ostream) const;
 
+  // Two boards are equal if they have the same size and cells.
+  bool operator==(const Board& other) const = default;
+
   // Swaps two rows by index, if both indices are valid, and returns
   // true. Otherwise, does nothing and returns false.
   //
@@ -92,17 +101,41 @@ class Board {
   ReverseRowIterator row_crbegin(const int row) const;
   ReverseRowIterator row_crend(const int row) const;
 
-  // Iterators for reading columns (forward and backward)
+  // Iterators for reading columns (forward and backward). They step
+  // through the board storage by `size()` cells.
   ColumnIterator column_cbegin(const int column) const;
   ColumnIterator column_cend(const int column) const;
   ReverseColumnIterator column_crbegin(const int column) const;
   ReverseColumnIterator column_crend(const int column) const;
 
+  // Views over a whole row or column. An invalid index gives an
+  // empty view.
+  RowSpan row(const int row) const;
+  ColumnSpan column(const int column) const;
+
  private:
+  // Returns the position of a cell in `cells_`. It is computed in
+  // size_t, as the cell count of the largest boards overflows an int.
+  size_t index(const int row, const int column) const {
+    return size_t(row) * size_ + column;
+  }
+
   const int size_;
 
-  // Each inner vector is a row, and the outer vector selects the row.
-  std::vector<std::vector<int>> board_;
+  // The cells in row-major order: each row is contiguous.
+  std::vector<int> cells_;
 };
 
+// Reads a board in the format written by `Board::print()`: the
+// number of values in the first row gives the size. Zeros are allowed
+// and mark empty cells. Returns nothing if the input is malformed.
+std::optional<Board> parse_board(std::istream& istream);
+
+// Cheap necessary conditions for a partial board, with zeros in the
+// free cells, to have a completion: no row or column repeats a value,
+// and in each of them the missing values can be matched to the free
+// cells whose column or row also misses them. Boards that pass may
+// still have no completion.
+bool is_partial_board_feasible(const Board& partial);
+
 #endif
@@ -0,0 +1,105 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "board_batch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// Counts, in every lane, the buildings visible along a line of `size`
+// cells that starts at `first` and moves by `stride` cells.
+void count_visible(const uint8_t* first, const int stride, const int size, const int count,
+                   const int capacity, uint8_t* visible) {
+  uint8_t highest[MAX_BATCH_CAPACITY] = {};
+  std::fill(visible, visible + count, 0);
+  for (int i = 0; i < size; ++i) {
+    const uint8_t* values = first + i * stride * capacity;
+    for (int lane = 0; lane < count; ++lane) {
+      visible[lane] += values[lane] > highest[lane];
+      highest[lane] = std::max(highest[lane], values[lane]);
+    }
+  }
+}
+
+// Clears `valid[lane]` in every lane where the line of `size` cells
+// that starts at `first` and moves by `stride` cells does not hold
+// every value once.
+void check_line(const uint8_t* first, const int stride, const int size, const int count,
+                const int capacity, bool* valid) {
+  uint32_t seen[MAX_BATCH_CAPACITY] = {};
+  for (int i = 0; i < size; ++i) {
+    const uint8_t* values = first + i * stride * capacity;
+    for (int lane = 0; lane < count; ++lane)
+      seen[lane] |= uint32_t{1} << values[lane];
+  }
+  // Bits 1 to size.
+  const uint32_t all = ((uint32_t{1} << size) - 1) << 1;
+  for (int lane = 0; lane < count; ++lane)
+    valid[lane] = valid[lane] && seen[lane] == all;
+}
+
+}  // namespace
+
+BoardBatch::BoardBatch(const int size, const int capacity)
+  : size_(size), capacity_(capacity), cells_(size * size * capacity) {
+  if (size_ <= 0 || size_ > MAX_BATCH_BOARD_SIZE || capacity_ <= 0 ||
+      capacity_ > MAX_BATCH_CAPACITY) {
+    std::cerr << "Bad board batch: " << capacity_ << " boards of size " << size_ << std::endl;
+    std::abort();
+  }
+}
+
+bool BoardBatch::add(const Board& board) {
+  if (count_ == capacity_ || board.size() != size_)
+    return false;
+  for (int row = 0; row < size_; ++row) {
+    const RowSpan values = board.row(row);
+    for (int column = 0; column < size_; ++column)
+      cells_[(row * size_ + column) * capacity_ + count_] = values[column];
+  }
+  ++count_;
+  return true;
+}
+
+void BoardBatch::compute_clues(uint8_t* clues) const {
+  uint8_t* top = clues;
+  uint8_t* bottom = clues + size_ * count_;
+  uint8_t* left = clues + 2 * size_ * count_;
+  uint8_t* right = clues + 3 * size_ * count_;
+  const int last = size_ - 1;
+
+  for (int column = 0; column < size_; ++column) {
+    count_visible(cell(0, column), size_, size_, count_, capacity_, top + column * count_);
+    count_visible(cell(last, column), -size_, size_, count_, capacity_, bottom + column * count_);
+  }
+  for (int row = 0; row < size_; ++row) {
+    count_visible(cell(row, 0), 1, size_, count_, capacity_, left + row * count_);
+    count_visible(cell(row, last), -1, size_, count_, capacity_, right + row * count_);
+  }
+}
+
+void BoardBatch::validate(bool* valid) const {
+  std::fill(valid, valid + count_, true);
+  for (int i = 0; i < size_; ++i) {
+    check_line(cell(i, 0), 1, size_, count_, capacity_, valid);
+    check_line(cell(0, i), size_, size_, count_, capacity_, valid);
+  }
+}
@@ -0,0 +1,73 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOARD_BATCH_H
+#define BOARD_BATCH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+
+// The largest board size, and the most boards, a batch holds.
+constexpr int MAX_BATCH_BOARD_SIZE = 16;
+constexpr int MAX_BATCH_CAPACITY = 64;
+
+// Up to `capacity` boards of the same size, in a structure-of-arrays
+// layout: the value of cell (row, column) of every board is stored
+// contiguously, one lane per board. Clues and validity are computed
+// for all the boards together, with loops over the lanes that the
+// compiler can vectorize.
+class BoardBatch {
+ public:
+  BoardBatch(const int size, const int capacity);
+
+  int size() const { return size_; }
+  int count() const { return count_; }
+  int capacity() const { return capacity_; }
+
+  // Copies a board into the next lane. Returns false if the batch is
+  // full or the board has a different size.
+  bool add(const Board& board);
+
+  // Empties the batch, keeping its storage.
+  void clear() { count_ = 0; }
+
+  // Computes the 4 * size() clues of every board. Clue i of the board
+  // in lane l, in the layout of `Puzzle::clues()`, is written to
+  // `clues[i * count() + l]`.
+  void compute_clues(uint8_t* clues) const;
+
+  // Sets `valid[l]` to whether the board in lane l is a valid Latin
+  // square.
+  void validate(bool* valid) const;
+
+ private:
+  // The values of cell (row, column) start at `(row * size_ + column)
+  // * capacity_`.
+  const uint8_t* cell(const int row, const int column) const {
+    return &cells_[(row * size_ + column) * capacity_];
+  }
+
+  const int size_;
+  const int capacity_;
+  int count_ = 0;
+  std::vector<uint8_t> cells_;
+};
+
+#endif
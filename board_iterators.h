@@ -19,44 +19,79 @@
 #ifndef BOARD_ITERATORS_H
 #define BOARD_ITERATORS_H
 
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
 #include <vector>
 
-class Board; // fwd decl
-
+// Rows are stored contiguously, so their iterators are those of the
+// board storage.
 using RowIterator = std::vector<int>::const_iterator;
 using ReverseRowIterator = std::vector<int>::const_reverse_iterator;
+using RowSpan = std::span<const int>;
 
-class ColumnIterator {
-public:
-  ColumnIterator(const Board& board, const int column, const int starting_row);
-
-  // Operators overloads
-  bool operator==(const ColumnIterator& rhs) const;
-  bool operator!=(const ColumnIterator& rhs) const;
-  int operator*();
-  ColumnIterator& operator++();
-
-private:
-  const Board& board_;
-  const int column_;
-  const int end_row_;
-  int current_row_;
-};
+// Aborts after an out-of-range access through a StridedIterator.
+[[noreturn]] void strided_access_failure(const std::ptrdiff_t index, const std::ptrdiff_t count);
+
+// A random-access iterator over `count` values, `stride` apart, such as
+// the cells of a column. Accesses are checked only in debug builds.
+class StridedIterator {
+ public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = int;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const int*;
+  using reference = const int&;
 
-class ReverseColumnIterator {
-public:
-  ReverseColumnIterator(const Board& board, const int column, const int starting_row);
+  StridedIterator() = default;
+  StridedIterator(const int* first, const difference_type stride, const difference_type index,
+                  const difference_type count)
+    : first_(first), stride_(stride), index_(index), count_(count) {}
+
+  reference operator*() const { return (*this)[0]; }
+  reference operator[](const difference_type n) const {
+#ifndef NDEBUG
+    if (index_ + n < 0 || index_ + n >= count_)
+      strided_access_failure(index_ + n, count_);
+#endif
+    return first_[(index_ + n) * stride_];
+  }
 
-  // Operators overloads
-  bool operator==(const ReverseColumnIterator& rhs) const;
-  bool operator!=(const ReverseColumnIterator& rhs) const;
-  int operator*();
-  ReverseColumnIterator& operator++();
+  StridedIterator& operator++() { ++index_; return *this; }
+  StridedIterator& operator--() { --index_; return *this; }
+  StridedIterator operator++(int) { StridedIterator old = *this; ++index_; return old; }
+  StridedIterator operator--(int) { StridedIterator old = *this; --index_; return old; }
+  StridedIterator& operator+=(const difference_type n) { index_ += n; return *this; }
+  StridedIterator& operator-=(const difference_type n) { index_ -= n; return *this; }
 
-private:
-  const Board& board_;
-  const int column_;
-  int current_row_;
+  friend StridedIterator operator+(StridedIterator it, const difference_type n) { return it += n; }
+  friend StridedIterator operator+(const difference_type n, StridedIterator it) { return it += n; }
+  friend StridedIterator operator-(StridedIterator it, const difference_type n) { return it -= n; }
+  friend difference_type operator-(const StridedIterator& lhs, const StridedIterator& rhs) {
+    return lhs.index_ - rhs.index_;
+  }
+
+  // Only iterators over the same values compare meaningfully.
+  bool operator==(const StridedIterator& rhs) const { return index_ == rhs.index_; }
+  std::strong_ordering operator<=>(const StridedIterator& rhs) const {
+    return index_ <=> rhs.index_;
+  }
+
+ private:
+  // The value at index 0; the iterator stands at `index_`.
+  const int* first_ = nullptr;
+  difference_type stride_ = 0;
+  difference_type index_ = 0;
+  // Kept in all builds, so that the layout does not depend on NDEBUG.
+  difference_type count_ = 0;
 };
 
+static_assert(std::random_access_iterator<StridedIterator>);
+
+using ColumnIterator = StridedIterator;
+using ReverseColumnIterator = std::reverse_iterator<StridedIterator>;
+using ColumnSpan = std::ranges::subrange<ColumnIterator>;
+
 #endif
@@ -0,0 +1,38 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "board_stream.h"
+
+#include "create.h"
+
+BoardStream::BoardStream(const CreateMode mode, const uint16_t board_size, const uint64_t seed)
+  : mode_(mode), seed_(seed), board_(board_size) {}
+
+bool BoardStream::next() {
+  // Reseeding per board keeps every board reproducible from its own
+  // seed, like in bulk creation.
+  generator_ = make_generator(seed_ + created_);
+  ++created_;
+  return fill_board(mode_, board_, generator_);
+}
+
+BoardStream::Iterator BoardStream::begin() {
+  Iterator it{this};
+  ++it;
+  return it;
+}
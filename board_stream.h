@@ -0,0 +1,105 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOARD_STREAM_H
+#define BOARD_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+
+#include "board.h"
+#include "options.h"
+
+// A lazy source of boards. Each call to next() creates exactly one
+// board, on demand, so consumers can pull as many boards as they need
+// and stop at any time, without any board being created in advance.
+//
+// The n-th board (starting from zero) is created with seed `seed + n`,
+// seeded as in `make_generator()`, so a stream yields the same boards
+// as bulk creation with the same seed, also past UINT32_MAX. All
+// boards are written into the same buffer: a reference returned by
+// board() stays valid, but its contents change on every call to
+// next().
+//
+// Usage:
+//   BoardStream stream{CreateMode::RANDOM, 9, seed};
+//   for (const Board& b : stream) {
+//     ...
+//   }
+class BoardStream {
+ public:
+  BoardStream(const CreateMode mode, const uint16_t board_size, const uint64_t seed);
+
+  // Creates the next board. Returns false if creation failed, in which
+  // case the stream is over.
+  bool next();
+
+  // The board created by the last call to next().
+  const Board& board() const { return board_; }
+
+  // The seed used to create the current board.
+  uint64_t seed() const { return seed_ + created_ - 1; }
+
+  // How many boards have been created so far.
+  uint64_t created() const { return created_; }
+
+  // Input iterator over the stream, for range-based for loops. The
+  // stream never ends unless creation fails.
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Board;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Board*;
+    using reference = const Board&;
+
+    Iterator() : stream_(nullptr) {}
+    explicit Iterator(BoardStream* stream) : stream_(stream) {}
+
+    reference operator*() const { return stream_->board(); }
+    pointer operator->() const { return &stream_->board(); }
+    Iterator& operator++() {
+      if (!stream_->next())
+        stream_ = nullptr;
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    bool operator==(const Iterator& other) const { return stream_ == other.stream_; }
+
+   private:
+    // Null for the end iterator.
+    BoardStream* stream_;
+  };
+
+  // Creates the first board not yet created, and returns an iterator
+  // to it.
+  Iterator begin();
+  Iterator end() { return Iterator{}; }
+
+ private:
+  const CreateMode mode_;
+  const uint64_t seed_;
+  uint64_t created_ = 0;
+  std::mt19937 generator_;
+  Board board_;
+};
+
+#endif
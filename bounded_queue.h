@@ -0,0 +1,164 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// A fixed-capacity, lock-free queue that supports any number of
+// producers and consumers. Each cell carries a sequence number that
+// tells producers and consumers whose turn it is to use it.
+//
+// The blocking push() and pop() sleep on a futex (through
+// std::atomic::wait) instead of spinning, and only pay for a wakeup
+// when some thread is actually asleep.
+//
+// T must be default-constructible and move-assignable.
+template <typename T>
+class BoundedQueue {
+ public:
+  // Builds a queue holding at least `capacity` elements. The capacity
+  // is rounded up to a power of two.
+  explicit BoundedQueue(const size_t capacity) {
+    size_t rounded = 2;
+    while (rounded < capacity)
+      rounded *= 2;
+    mask_ = rounded - 1;
+    cells_ = std::make_unique<Cell[]>(rounded);
+    for (size_t i = 0; i < rounded; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Moves `value` into the queue, and returns true. If the queue is
+  // full, does nothing and returns false.
+  bool try_push(T& value) {
+    size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[position & mask_];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const intptr_t difference = intptr_t(sequence) - intptr_t(position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                    std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // Full.
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Moves the oldest element into `value`, and returns true. If the
+  // queue is empty, does nothing and returns false.
+  bool try_pop(T& value) {
+    size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[position & mask_];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const intptr_t difference = intptr_t(sequence) - intptr_t(position + 1);
+      if (difference == 0) {
+        if (dequeue_position_.compare_exchange_weak(position, position + 1,
+                                                    std::memory_order_relaxed)) {
+          value = std::move(cell.value);
+          cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // Empty.
+        return false;
+      } else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Like try_push(), but waits for room if the queue is full. This is
+  // what applies backpressure to the producers.
+  void push(T value) {
+    while (true) {
+      const uint32_t pops = pops_.load();
+      if (try_push(value))
+        break;
+      wait_for(pops_, pops, waiting_producers_);
+    }
+    signal(pushes_, waiting_consumers_);
+  }
+
+  // Like try_pop(), but waits for an element if the queue is empty.
+  T pop() {
+    T value;
+    while (true) {
+      const uint32_t pushes = pushes_.load();
+      if (try_pop(value))
+        break;
+      wait_for(pushes_, pushes, waiting_consumers_);
+    }
+    signal(pops_, waiting_producers_);
+    return value;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  // Sleeps until `counter` moves past `seen`. Registering as a waiter
+  // before the check pairs with signal() bumping the counter before
+  // reading the waiters, so that no wakeup is lost.
+  static void wait_for(std::atomic<uint32_t>& counter, const uint32_t seen,
+                       std::atomic<int>& waiters) {
+    waiters.fetch_add(1);
+    counter.wait(seen);
+    waiters.fetch_sub(1);
+  }
+
+  static void signal(std::atomic<uint32_t>& counter, std::atomic<int>& waiters) {
+    counter.fetch_add(1);
+    if (waiters.load() > 0)
+      counter.notify_one();
+  }
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  // Keep the two ends on separate cache lines, since they are updated
+  // by different threads.
+  alignas(64) std::atomic<size_t> enqueue_position_{0};
+  alignas(64) std::atomic<size_t> dequeue_position_{0};
+  // Bumped after every blocking push() and pop(), for the threads
+  // waiting on the other end.
+  alignas(64) std::atomic<uint32_t> pushes_{0};
+  std::atomic<int> waiting_consumers_{0};
+  alignas(64) std::atomic<uint32_t> pops_{0};
+  std::atomic<int> waiting_producers_{0};
+};
+
+#endif
@@ -0,0 +1,735 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cdcl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+// A literal is a variable with a sign: 2 * var for the positive
+// literal, and 2 * var + 1 for the negative one.
+using Lit = int32_t;
+
+Lit positive(const int var) { return 2 * var; }
+Lit negative(const int var) { return 2 * var + 1; }
+int var_of(const Lit lit) { return lit >> 1; }
+Lit negate(const Lit lit) { return lit ^ 1; }
+
+// Stand-ins for constant literals while encoding. Clauses that contain
+// TRUE_LIT are dropped, and FALSE_LIT is dropped from clauses. Like
+// real literals, negate() turns each into the other.
+constexpr Lit TRUE_LIT = -1;
+constexpr Lit FALSE_LIT = -2;
+
+// A reference to a clause: its offset in the clause arena.
+using ClauseRef = uint32_t;
+constexpr ClauseRef NO_REASON = UINT32_MAX;
+
+// Restart intervals follow the Luby sequence, in units of this many
+// conflicts.
+constexpr long RESTART_UNIT = 100;
+// How often the search checks for cancellation.
+constexpr long CANCEL_CHECK_INTERVAL = 256;
+// Learned clauses whose literals span at most this many decision
+// levels are never deleted.
+constexpr int KEEP_LBD = 2;
+
+// Returns the i-th element (from 0) of the Luby sequence
+// 1, 1, 2, 1, 1, 2, 4, 1, ...
+long luby(long i) {
+  long size = 1;
+  int exponent = 0;
+  while (size < i + 1) {
+    size = 2 * size + 1;
+    ++exponent;
+  }
+  while (size - 1 != i) {
+    size = (size - 1) / 2;
+    --exponent;
+    i %= size;
+  }
+  return 1L << exponent;
+}
+
+class CdclSolver {
+ public:
+  enum class Result { SATISFIABLE, UNSATISFIABLE, CANCELLED };
+
+  explicit CdclSolver(const uint32_t seed) : generator_(seed), randomize_(seed != 0) {}
+
+  int new_var() {
+    const int var = assigns_.size();
+    assigns_.push_back(0);
+    levels_.push_back(0);
+    reasons_.push_back(NO_REASON);
+    polarity_.push_back(0);
+    seen_.push_back(0);
+    activity_.push_back(randomize_ ? std::uniform_real_distribution<double>{0, 1e-5}(generator_) : 0);
+    heap_index_.push_back(-1);
+    watches_.emplace_back();
+    watches_.emplace_back();
+    heap_insert(var);
+    return var;
+  }
+
+  // Adds a clause before the search starts, or between solutions.
+  // Returns false if the problem became unsatisfiable.
+  bool add_clause(std::vector<Lit> lits) {
+    if (unsatisfiable_)
+      return false;
+    cancel_until(0);
+    std::sort(lits.begin(), lits.end());
+    size_t kept = 0;
+    for (size_t i = 0; i < lits.size(); ++i) {
+      const Lit lit = lits[i];
+      if (lit == TRUE_LIT)
+        return true;
+      if (lit == FALSE_LIT || value(lit) < 0 || (kept > 0 && lits[kept - 1] == lit))
+        continue;
+      if (value(lit) > 0 || (kept > 0 && lits[kept - 1] == negate(lit)))
+        // The clause is always satisfied.
+        return true;
+      lits[kept++] = lit;
+    }
+    lits.resize(kept);
+
+    if (lits.empty()) {
+      unsatisfiable_ = true;
+    } else if (lits.size() == 1) {
+      enqueue(lits[0], NO_REASON);
+      unsatisfiable_ = propagate() != NO_REASON;
+    } else {
+      attach(allocate(lits, /*learnt=*/false, 0));
+    }
+    return !unsatisfiable_;
+  }
+
+  Result solve(const SolverOptions& options) {
+    if (unsatisfiable_)
+      return Result::UNSATISFIABLE;
+
+    long restarts = 0;
+    long conflicts_left = RESTART_UNIT * luby(restarts);
+    std::vector<Lit> learnt;
+    while (true) {
+      const ClauseRef conflict = propagate();
+      if (conflict != NO_REASON) {
+        ++conflicts_;
+        if (decision_level() == 0) {
+          unsatisfiable_ = true;
+          return Result::UNSATISFIABLE;
+        }
+        int backjump_level;
+        int lbd;
+        analyze(conflict, &learnt, &backjump_level, &lbd);
+        cancel_until(backjump_level);
+        if (learnt.size() == 1) {
+          enqueue(learnt[0], NO_REASON);
+        } else {
+          const ClauseRef ref = allocate(learnt, /*learnt=*/true, lbd);
+          learnts_.push_back(ref);
+          attach(ref);
+          enqueue(learnt[0], ref);
+        }
+        decay_activity();
+        --conflicts_left;
+        if (conflicts_ % CANCEL_CHECK_INTERVAL == 0 && stop_requested(options))
+          return Result::CANCELLED;
+        continue;
+      }
+
+      if (conflicts_left <= 0) {
+        cancel_until(0);
+        conflicts_left = RESTART_UNIT * luby(++restarts);
+        if (long(learnts_.size()) >= max_learnts_)
+          reduce_learnts();
+      }
+
+      const int var = pick_branch_var();
+      if (var < 0)
+        return Result::SATISFIABLE;
+      ++decisions_;
+      if ((options.max_nodes > 0 && decisions_ > options.max_nodes) ||
+          (decisions_ % CANCEL_CHECK_INTERVAL == 0 && stop_requested(options)))
+        return Result::CANCELLED;
+      trail_limits_.push_back(trail_.size());
+      enqueue(polarity_[var] ? positive(var) : negative(var), NO_REASON);
+    }
+  }
+
+  // The value of a variable in the last solution found.
+  bool model_value(const int var) const { return assigns_[var] > 0; }
+
+  long decisions() const { return decisions_; }
+  long conflicts() const { return conflicts_; }
+
+ private:
+  struct Watch {
+    ClauseRef clause;
+    // Another literal of the clause. If it is true, the clause need
+    // not be visited.
+    Lit blocker;
+  };
+
+  // The arena stores each clause as its size, its flags and then its
+  // literals.
+  static constexpr int HEADER = 2;
+  int clause_size(const ClauseRef ref) const { return arena_[ref]; }
+  Lit* clause_lits(const ClauseRef ref) { return &arena_[ref + HEADER]; }
+  int clause_lbd(const ClauseRef ref) const { return arena_[ref + 1]; }
+
+  ClauseRef allocate(const std::vector<Lit>& lits, const bool learnt, const int lbd) {
+    const ClauseRef ref = arena_.size();
+    arena_.push_back(lits.size());
+    arena_.push_back(learnt ? lbd : 0);
+    arena_.insert(arena_.end(), lits.begin(), lits.end());
+    return ref;
+  }
+
+  void attach(const ClauseRef ref) {
+    const Lit* lits = clause_lits(ref);
+    watches_[negate(lits[0])].push_back(Watch{ref, lits[1]});
+    watches_[negate(lits[1])].push_back(Watch{ref, lits[0]});
+  }
+
+  // 1 if the literal is true, -1 if false, 0 if unassigned.
+  int value(const Lit lit) const {
+    const int v = assigns_[var_of(lit)];
+    return (lit & 1) ? -v : v;
+  }
+
+  int decision_level() const { return trail_limits_.size(); }
+
+  void enqueue(const Lit lit, const ClauseRef reason) {
+    const int var = var_of(lit);
+    assigns_[var] = (lit & 1) ? -1 : 1;
+    levels_[var] = decision_level();
+    reasons_[var] = reason;
+    trail_.push_back(lit);
+  }
+
+  void cancel_until(const int level) {
+    if (decision_level() <= level)
+      return;
+    for (size_t i = trail_.size(); i > size_t(trail_limits_[level]); --i) {
+      const int var = var_of(trail_[i - 1]);
+      // Phase saving: branch the same way next time.
+      polarity_[var] = assigns_[var] > 0;
+      assigns_[var] = 0;
+      reasons_[var] = NO_REASON;
+      if (heap_index_[var] < 0)
+        heap_insert(var);
+    }
+    trail_.resize(trail_limits_[level]);
+    trail_limits_.resize(level);
+    propagated_ = std::min(propagated_, trail_.size());
+  }
+
+  // Propagates all the enqueued literals. Returns the clause that
+  // became false, if any.
+  ClauseRef propagate() {
+    while (propagated_ < trail_.size()) {
+      const Lit lit = trail_[propagated_++];
+      const Lit false_lit = negate(lit);
+      std::vector<Watch>& watches = watches_[lit];
+      size_t kept = 0;
+      size_t i = 0;
+      while (i < watches.size()) {
+        const Watch w = watches[i++];
+        if (value(w.blocker) > 0) {
+          watches[kept++] = w;
+          continue;
+        }
+        Lit* lits = clause_lits(w.clause);
+        if (lits[0] == false_lit)
+          std::swap(lits[0], lits[1]);
+        const Lit first = lits[0];
+        if (first != w.blocker && value(first) > 0) {
+          watches[kept++] = Watch{w.clause, first};
+          continue;
+        }
+
+        // Look for another literal to watch.
+        const int size = clause_size(w.clause);
+        bool moved = false;
+        for (int k = 2; k < size; ++k) {
+          if (value(lits[k]) >= 0) {
+            lits[1] = lits[k];
+            lits[k] = false_lit;
+            watches_[negate(lits[1])].push_back(Watch{w.clause, first});
+            moved = true;
+            break;
+          }
+        }
+        if (moved)
+          continue;
+
+        // The clause is unit or false.
+        watches[kept++] = Watch{w.clause, first};
+        if (value(first) < 0) {
+          while (i < watches.size())
+            watches[kept++] = watches[i++];
+          watches.resize(kept);
+          propagated_ = trail_.size();
+          return w.clause;
+        }
+        enqueue(first, w.clause);
+      }
+      watches.resize(kept);
+    }
+    return NO_REASON;
+  }
+
+  // Derives a first-UIP clause from a conflict. Its first literal is
+  // the one to assert after backjumping, and its second one belongs to
+  // the backjump level.
+  void analyze(ClauseRef conflict, std::vector<Lit>* learnt, int* backjump_level, int* lbd) {
+    learnt->clear();
+    learnt->push_back(0);
+    int pending = 0;
+    Lit lit = -1;
+    size_t index = trail_.size();
+    do {
+      const Lit* lits = clause_lits(conflict);
+      const int size = clause_size(conflict);
+      for (int j = lit < 0 ? 0 : 1; j < size; ++j) {
+        const int var = var_of(lits[j]);
+        if (seen_[var] || levels_[var] == 0)
+          continue;
+        seen_[var] = 1;
+        bump_activity(var);
+        if (levels_[var] >= decision_level())
+          ++pending;
+        else
+          learnt->push_back(lits[j]);
+      }
+      // Walk back to the next marked literal of the current level.
+      while (!seen_[var_of(trail_[--index])]) {}
+      lit = trail_[index];
+      conflict = reasons_[var_of(lit)];
+      seen_[var_of(lit)] = 0;
+      --pending;
+    } while (pending > 0);
+    (*learnt)[0] = negate(lit);
+
+    // Drop the literals implied by other literals of the clause. The
+    // dropped literals stay marked until the end, as they still imply
+    // the ones after them.
+    marked_ = *learnt;
+    size_t kept = 1;
+    for (size_t i = 1; i < learnt->size(); ++i) {
+      const Lit l = (*learnt)[i];
+      const ClauseRef reason = reasons_[var_of(l)];
+      bool redundant = reason != NO_REASON;
+      if (redundant) {
+        const Lit* lits = clause_lits(reason);
+        const int size = clause_size(reason);
+        for (int j = 1; j < size && redundant; ++j) {
+          const int var = var_of(lits[j]);
+          redundant = seen_[var] || levels_[var] == 0;
+        }
+      }
+      if (!redundant)
+        (*learnt)[kept++] = l;
+    }
+    learnt->resize(kept);
+    for (size_t i = 1; i < marked_.size(); ++i)
+      seen_[var_of(marked_[i])] = 0;
+
+    // Backjump to the highest level among the other literals.
+    *backjump_level = 0;
+    if (learnt->size() > 1) {
+      size_t highest = 1;
+      for (size_t i = 2; i < learnt->size(); ++i) {
+        if (levels_[var_of((*learnt)[i])] > levels_[var_of((*learnt)[highest])])
+          highest = i;
+      }
+      std::swap((*learnt)[1], (*learnt)[highest]);
+      *backjump_level = levels_[var_of((*learnt)[1])];
+    }
+
+    // Count the distinct decision levels in the clause.
+    std::vector<int>& levels = lbd_levels_;
+    levels.clear();
+    for (const Lit l : *learnt)
+      levels.push_back(levels_[var_of(l)]);
+    std::sort(levels.begin(), levels.end());
+    *lbd = std::unique(levels.begin(), levels.end()) - levels.begin();
+  }
+
+  // Deletes half of the learned clauses, keeping the ones that span
+  // few decision levels, and simplifies the rest with the assignments
+  // of level 0. Only called at level 0, after propagation, where no
+  // clause is the reason for an assignment that analysis may visit.
+  void reduce_learnts() {
+    std::vector<ClauseRef> by_lbd = learnts_;
+    std::stable_sort(by_lbd.begin(), by_lbd.end(), [this](const ClauseRef a, const ClauseRef b) {
+      return clause_lbd(a) < clause_lbd(b);
+    });
+    std::vector<char> is_learnt(arena_.size());
+    std::vector<char> dropped(arena_.size());
+    for (size_t i = 0; i < by_lbd.size(); ++i) {
+      is_learnt[by_lbd[i]] = 1;
+      dropped[by_lbd[i]] = i >= by_lbd.size() / 2 && clause_lbd(by_lbd[i]) > KEEP_LBD;
+    }
+
+    // Rebuild the arena with the surviving clauses, and the watches.
+    std::vector<Lit> arena;
+    arena.reserve(arena_.size());
+    learnts_.clear();
+    for (ClauseRef ref = 0; ref < arena_.size(); ref += HEADER + clause_size(ref)) {
+      if (dropped[ref])
+        continue;
+      const Lit* lits = clause_lits(ref);
+      const int size = clause_size(ref);
+      if (std::any_of(lits, lits + size, [this](const Lit l) { return value(l) > 0; }))
+        // Satisfied for good.
+        continue;
+      const ClauseRef moved = arena.size();
+      arena.push_back(0);
+      arena.push_back(arena_[ref + 1]);
+      for (int i = 0; i < size; ++i) {
+        if (value(lits[i]) == 0)
+          arena.push_back(lits[i]);
+      }
+      arena[moved] = arena.size() - moved - HEADER;
+      if (is_learnt[ref])
+        learnts_.push_back(moved);
+    }
+    arena_.swap(arena);
+    for (std::vector<Watch>& w : watches_)
+      w.clear();
+    for (ClauseRef ref = 0; ref < arena_.size(); ref += HEADER + clause_size(ref))
+      attach(ref);
+    for (const Lit lit : trail_)
+      reasons_[var_of(lit)] = NO_REASON;
+    max_learnts_ += max_learnts_ / 10;
+  }
+
+  int pick_branch_var() {
+    while (!heap_.empty()) {
+      const int var = heap_pop();
+      if (assigns_[var] == 0)
+        return var;
+    }
+    return -1;
+  }
+
+  void bump_activity(const int var) {
+    activity_[var] += activity_increment_;
+    if (activity_[var] > 1e100) {
+      for (double& a : activity_)
+        a *= 1e-100;
+      activity_increment_ *= 1e-100;
+    }
+    if (heap_index_[var] >= 0)
+      heap_up(heap_index_[var]);
+  }
+
+  void decay_activity() { activity_increment_ /= 0.95; }
+
+  // A binary max-heap of variables, by activity.
+  void heap_insert(const int var) {
+    heap_index_[var] = heap_.size();
+    heap_.push_back(var);
+    heap_up(heap_.size() - 1);
+  }
+
+  int heap_pop() {
+    const int top = heap_[0];
+    heap_index_[top] = -1;
+    const int last = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+      heap_[0] = last;
+      heap_index_[last] = 0;
+      heap_down(0);
+    }
+    return top;
+  }
+
+  void heap_up(size_t i) {
+    const int var = heap_[i];
+    while (i > 0 && activity_[heap_[(i - 1) / 2]] < activity_[var]) {
+      heap_[i] = heap_[(i - 1) / 2];
+      heap_index_[heap_[i]] = i;
+      i = (i - 1) / 2;
+    }
+    heap_[i] = var;
+    heap_index_[var] = i;
+  }
+
+  void heap_down(size_t i) {
+    const int var = heap_[i];
+    while (2 * i + 1 < heap_.size()) {
+      size_t child = 2 * i + 1;
+      if (child + 1 < heap_.size() && activity_[heap_[child + 1]] > activity_[heap_[child]])
+        ++child;
+      if (activity_[heap_[child]] <= activity_[var])
+        break;
+      heap_[i] = heap_[child];
+      heap_index_[heap_[i]] = i;
+      i = child;
+    }
+    heap_[i] = var;
+    heap_index_[var] = i;
+  }
+
+  std::mt19937 generator_;
+  const bool randomize_;
+  bool unsatisfiable_ = false;
+
+  // Per variable.
+  std::vector<int8_t> assigns_;
+  std::vector<int> levels_;
+  std::vector<ClauseRef> reasons_;
+  std::vector<char> polarity_;
+  std::vector<char> seen_;
+  std::vector<double> activity_;
+  std::vector<int> heap_index_;
+  // Per literal: the clauses to visit when the literal becomes true.
+  std::vector<std::vector<Watch>> watches_;
+
+  std::vector<Lit> arena_;
+  std::vector<ClauseRef> learnts_;
+  long max_learnts_ = 20000;
+
+  std::vector<Lit> trail_;
+  std::vector<int> trail_limits_;
+  size_t propagated_ = 0;
+
+  std::vector<int> heap_;
+  double activity_increment_ = 1;
+  std::vector<int> lbd_levels_;
+  std::vector<Lit> marked_;
+
+  long decisions_ = 0;
+  long conflicts_ = 0;
+};
+
+// Encodes a puzzle into clauses. Variable `cell * size + value - 1`
+// is true when the cell holds the value.
+class Encoder {
+ public:
+  Encoder(const int size, CdclSolver& solver) : size_(size), solver_(solver) {
+    for (int i = 0; i < size * size * size; ++i)
+      solver_.new_var();
+  }
+
+  Lit cell_value(const int cell, const int value) const {
+    return positive(cell * size_ + value - 1);
+  }
+
+  bool add(std::vector<Lit> lits) { return solver_.add_clause(std::move(lits)); }
+
+  // Every cell holds one value, and every value appears once in each
+  // row and column.
+  bool encode_latin() {
+    const int n = size_;
+    std::vector<Lit> group(n);
+    for (int kind = 0; kind < 3; ++kind) {
+      for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+          for (int i = 0; i < n; ++i) {
+            switch (kind) {
+            case 0: group[i] = cell_value(a * n + b, i + 1); break;  // cell (a, b)
+            case 1: group[i] = cell_value(a * n + i, b + 1); break;  // value b + 1 in row a
+            default: group[i] = cell_value(i * n + a, b + 1); break; // value b + 1 in column a
+            }
+          }
+          if (!exactly_one(group))
+            return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Constrains the number of buildings visible along `cells`, which
+  // are listed starting from the observer.
+  bool encode_visibility(const int clue, const std::vector<int>& cells) {
+    const int n = size_;
+
+    // A value at distance `d` can be at most `size - clue + 1 + d`.
+    // This is implied by the rest, but helps the search a lot.
+    for (int d = 0; d < clue - 1; ++d) {
+      for (int value = n - clue + 2 + d; value <= n; ++value) {
+        if (!add({negate(cell_value(cells[d], value))}))
+          return false;
+      }
+    }
+
+    // at_least[i][k]: the tallest of the first i + 1 buildings is at
+    // least k tall.
+    std::vector<std::vector<Lit>> at_least(n, std::vector<Lit>(n + 1));
+    for (int i = 0; i < n; ++i) {
+      at_least[i][0] = at_least[i][1] = TRUE_LIT;
+      for (int k = 2; k <= n; ++k)
+        at_least[i][k] = positive(solver_.new_var());
+    }
+    auto tallest = [&](const int i, const int k) {
+      return i < 0 ? FALSE_LIT : at_least[i][k];
+    };
+    for (int i = 0; i < n; ++i) {
+      for (int k = 2; k <= n; ++k) {
+        const Lit m = at_least[i][k];
+        std::vector<Lit> support{negate(m), tallest(i - 1, k)};
+        for (int value = k; value <= n; ++value)
+          support.push_back(cell_value(cells[i], value));
+        if (!add({negate(cell_value(cells[i], k)), m}) ||
+            !add({negate(tallest(i - 1, k)), m}) ||
+            !add({negate(m), at_least[i][k - 1]}) ||
+            !add(std::move(support)))
+          return false;
+      }
+    }
+
+    // visible[i]: the i-th building is taller than all the previous ones.
+    std::vector<Lit> visible(n);
+    visible[0] = TRUE_LIT;
+    for (int i = 1; i < n; ++i) {
+      visible[i] = positive(solver_.new_var());
+      for (int value = 1; value <= n; ++value) {
+        const Lit x = negate(cell_value(cells[i], value));
+        if (!add({x, tallest(i - 1, value), visible[i]}) ||
+            !add({x, negate(tallest(i - 1, value)), negate(visible[i])}))
+          return false;
+      }
+    }
+
+    // count[i][j]: at least j of the first i + 1 buildings are visible,
+    // as a sequential counter up to clue + 1.
+    const int top = std::min(clue + 1, n);
+    std::vector<std::vector<Lit>> count(n, std::vector<Lit>(top + 1));
+    auto counted = [&](const int i, const int j) {
+      if (j == 0)
+        return TRUE_LIT;
+      if (i < 0 || j > i + 1)
+        return FALSE_LIT;
+      return count[i][j];
+    };
+    for (int i = 0; i < n; ++i) {
+      for (int j = 1; j <= top && j <= i + 1; ++j) {
+        count[i][j] = positive(solver_.new_var());
+        const Lit c = count[i][j];
+        if (!add({negate(counted(i - 1, j)), c}) ||
+            !add({negate(counted(i - 1, j - 1)), negate(visible[i]), c}) ||
+            !add({negate(c), counted(i - 1, j), visible[i]}) ||
+            !add({negate(c), counted(i - 1, j), counted(i - 1, j - 1)}))
+          return false;
+      }
+    }
+    if (!add({counted(n - 1, clue)}))
+      return false;
+    return clue + 1 > n || add({negate(counted(n - 1, clue + 1))});
+  }
+
+ private:
+  bool exactly_one(const std::vector<Lit>& lits) {
+    if (!add(lits))
+      return false;
+    for (size_t i = 0; i < lits.size(); ++i) {
+      for (size_t j = i + 1; j < lits.size(); ++j) {
+        if (!add({negate(lits[i]), negate(lits[j])}))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  const int size_;
+  CdclSolver& solver_;
+};
+
+// Encodes the whole puzzle. Returns false if it is found to be
+// unsatisfiable while encoding.
+bool encode(const int size, const int* clues, CdclSolver& solver) {
+  Encoder encoder{size, solver};
+  if (!encoder.encode_latin())
+    return false;
+  std::vector<int> cells(size);
+  for (int side = 0; side < 4; ++side) {
+    for (int line = 0; line < size; ++line) {
+      const int clue = clues[side * size + line];
+      if (clue == 0)
+        continue;
+      for (int d = 0; d < size; ++d) {
+        switch (side) {
+        case 0: cells[d] = d * size + line; break;                 // top
+        case 1: cells[d] = (size - 1 - d) * size + line; break;    // bottom
+        case 2: cells[d] = line * size + d; break;                 // left
+        default: cells[d] = line * size + (size - 1 - d); break;   // right
+        }
+      }
+      if (!encoder.encode_visibility(clue, cells))
+        return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+SolveStatus solve_clues_cdcl(const int size, const int* clues, const SolverOptions& options,
+                             int* solution, SolverStats* stats) {
+  SolverStats local_stats;
+  if (stats == nullptr)
+    stats = &local_stats;
+  *stats = SolverStats{};
+
+  if (size <= 0 || size > MAX_CDCL_SIZE || options.max_solutions < 1)
+    return SolveStatus::INVALID_INPUT;
+  for (int i = 0; i < 4 * size; ++i) {
+    if (clues[i] < 0 || clues[i] > size)
+      return SolveStatus::INVALID_INPUT;
+  }
+
+  CdclSolver solver{options.seed};
+  const int cells = size * size;
+  bool satisfiable = encode(size, clues, solver);
+  while (satisfiable) {
+    const CdclSolver::Result result = solver.solve(options);
+    stats->nodes = solver.decisions();
+    stats->backtracks = solver.conflicts();
+    if (result == CdclSolver::Result::CANCELLED)
+      return SolveStatus::CANCELLED;
+    if (result == CdclSolver::Result::UNSATISFIABLE)
+      break;
+
+    // Record the solution, and exclude it to look for the next one.
+    std::vector<Lit> block;
+    for (int cell = 0; cell < cells; ++cell) {
+      for (int value = 1; value <= size; ++value) {
+        if (solver.model_value(cell * size + value - 1)) {
+          if (stats->solutions == 0)
+            solution[cell] = value;
+          block.push_back(negative(cell * size + value - 1));
+        }
+      }
+    }
+    if (++stats->solutions >= options.max_solutions)
+      return SolveStatus::SOLVED;
+    satisfiable = solver.add_clause(std::move(block));
+  }
+  return stats->solutions > 0 ? SolveStatus::SOLVED : SolveStatus::NO_SOLUTION;
+}
@@ -0,0 +1,45 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CDCL_H
+#define CDCL_H
+
+#include "solve.h"
+
+// The largest board the CDCL backend accepts. The encoding grows with
+// the fourth power of the size.
+constexpr int MAX_CDCL_SIZE = 32;
+
+// Solves the puzzle with the given clues (see `SolverState`) with a
+// conflict-driven clause learning search, writing the first solution
+// found to `solution` in row-major order.
+//
+// The puzzle is encoded as a SAT problem: one variable per value of
+// each cell, plus auxiliary variables that track the tallest building
+// seen so far and the number of visible buildings from each clue. The
+// search uses watched literals, first-UIP learning with backjumping,
+// VSIDS branching with phase saving, and Luby restarts.
+//
+// Unlike `solve_clues()`, this allocates its own memory. The variable
+// and value orders are ignored; a nonzero seed perturbs the initial
+// branching order. In `stats`, nodes are decisions and backtracks are
+// conflicts, and `max_nodes` bounds the decisions.
+SolveStatus solve_clues_cdcl(const int size, const int* clues, const SolverOptions& options,
+                             int* solution, SolverStats* stats);
+
+#endif
@@ -0,0 +1,278 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "clue_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "board.h"
+#include "board_batch.h"
+#include "create.h"
+#include "options.h"
+#include "puzzle.h"
+#include "puzzle_file.h"
+
+namespace {
+
+// Generating workers claim this many seeds at a time. Small boards
+// are then handled as one batch.
+constexpr uint64_t SEEDS_PER_CLAIM = 64;
+static_assert(SEEDS_PER_CLAIM <= MAX_BATCH_CAPACITY);
+
+const char* const SIDE_NAMES[] = {"top", "bottom", "left", "right"};
+
+// Writes `text` as the contents of a JSON string, escaping quotes,
+// backslashes and control characters.
+void print_json_string(std::ostream& ostream, const std::string& text) {
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      ostream << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      const char* const digits = "0123456789abcdef";
+      ostream << "\\u00" << digits[c >> 4] << digits[c & 0xf];
+    } else {
+      ostream << c;
+    }
+  }
+}
+
+// Returns the Pearson correlation of the pairs counted in `pairs`, an
+// array of (size + 1) * (size + 1) counts, ignoring missing clues.
+// Returns nothing if either value is constant.
+std::optional<double> correlation(const uint64_t* pairs, const int size) {
+  double n = 0, sum_a = 0, sum_b = 0, sum_aa = 0, sum_bb = 0, sum_ab = 0;
+  for (int a = 1; a <= size; ++a) {
+    for (int b = 1; b <= size; ++b) {
+      const double count = pairs[a * (size + 1) + b];
+      n += count;
+      sum_a += count * a;
+      sum_b += count * b;
+      sum_aa += count * a * a;
+      sum_bb += count * b * b;
+      sum_ab += count * a * b;
+    }
+  }
+  const double variance_a = n * sum_aa - sum_a * sum_a;
+  const double variance_b = n * sum_bb - sum_b * sum_b;
+  if (n == 0 || variance_a <= 0 || variance_b <= 0)
+    return std::nullopt;
+  return (n * sum_ab - sum_a * sum_b) / std::sqrt(variance_a * variance_b);
+}
+
+void print_correlation(std::ostream& ostream, const std::optional<double>& value) {
+  if (value.has_value())
+    ostream << *value;
+  else
+    ostream << "null";
+}
+
+// Counts the clues of every board in a batch. Returns false if one of
+// them is not valid.
+bool count_batch(const BoardBatch& batch, ClueHistogram& histogram) {
+  const int size = batch.size();
+  const int count = batch.count();
+  bool valid[MAX_BATCH_CAPACITY];
+  batch.validate(valid);
+  uint8_t clues[4 * MAX_BATCH_BOARD_SIZE * MAX_BATCH_CAPACITY];
+  batch.compute_clues(clues);
+  int lane_clues[4 * MAX_BATCH_BOARD_SIZE];
+  for (int lane = 0; lane < count; ++lane) {
+    if (!valid[lane])
+      return false;
+    for (int i = 0; i < 4 * size; ++i)
+      lane_clues[i] = clues[i * count + lane];
+    histogram.add(lane_clues);
+  }
+  return true;
+}
+
+// Creates `count` boards from consecutive seeds on `threads` threads,
+// and counts their clues into one histogram per thread.
+bool generate_histograms(const ProgramOptions& options, const int threads,
+                         std::vector<std::map<int, ClueHistogram>>& histograms) {
+  const CreateOptions& create_options = options.create_options;
+  const int size = options.board_size;
+  // The JSON report may go to stdout, so the seed is reported on
+  // stderr.
+  const uint64_t base_seed = resolve_seed(create_options, std::cerr);
+  const uint64_t count = create_options.count;
+  std::atomic<uint64_t> next{0};
+  std::atomic<bool> failed{false};
+
+  std::vector<std::thread> workers;
+  for (int worker = 0; worker < threads; ++worker) {
+    workers.emplace_back([&, worker] {
+      ClueHistogram& histogram = histograms[worker].try_emplace(size, size).first->second;
+      Board b{size};
+      std::vector<int> cells(size * size);
+      std::vector<int> clues(4 * size);
+      std::optional<BoardBatch> batch;
+      if (size <= MAX_BATCH_BOARD_SIZE)
+        batch.emplace(size, SEEDS_PER_CLAIM);
+      while (!failed.load(std::memory_order_relaxed)) {
+        const uint64_t first = next.fetch_add(SEEDS_PER_CLAIM, std::memory_order_relaxed);
+        if (first >= count)
+          break;
+        const uint64_t last = std::min(count, first + SEEDS_PER_CLAIM);
+        for (uint64_t n = first; n < last; ++n) {
+          std::mt19937 generator = make_generator(base_seed + n);
+          if (!fill_board(create_options.mode, b, generator)) {
+            std::cerr << "ERROR: something went wrong while creating the board with seed "
+                      << base_seed + n << std::endl;
+            failed.store(true);
+            break;
+          }
+          if (batch.has_value()) {
+            batch->add(b);
+            continue;
+          }
+          for (int row = 0; row < size; ++row) {
+            for (int column = 0; column < size; ++column)
+              cells[row * size + column] = b.at(row, column);
+          }
+          compute_clues(size, cells.data(), clues.data());
+          histogram.add(clues.data());
+        }
+        if (batch.has_value()) {
+          if (!failed.load(std::memory_order_relaxed) && !count_batch(*batch, histogram)) {
+            std::cerr << "FATAL: created an invalid board from a seed between " << base_seed + first
+                      << " and " << base_seed + last - 1 << ". This should never happen."
+                      << std::endl;
+            failed.store(true);
+          }
+          batch->clear();
+        }
+      }
+    });
+  }
+  for (std::thread& t : workers)
+    t.join();
+  return !failed.load();
+}
+
+}  // namespace
+
+ClueHistogram::ClueHistogram(const int size)
+  : size_(size), sides_(4 * (size + 1)), pairs_(2 * (size + 1) * (size + 1)) {}
+
+void ClueHistogram::add(const int* clues) {
+  const int* top = clues;
+  const int* bottom = clues + size_;
+  const int* left = clues + 2 * size_;
+  const int* right = clues + 3 * size_;
+  const int values = size_ + 1;
+  ++puzzles_;
+  for (int side = 0; side < 4; ++side) {
+    for (int i = 0; i < size_; ++i)
+      ++sides_[side * values + clues[side * size_ + i]];
+  }
+  for (int i = 0; i < size_; ++i) {
+    ++pairs_[top[i] * values + bottom[i]];
+    ++pairs_[values * values + left[i] * values + right[i]];
+  }
+}
+
+void ClueHistogram::merge(const ClueHistogram& other) {
+  puzzles_ += other.puzzles_;
+  for (size_t i = 0; i < sides_.size(); ++i)
+    sides_[i] += other.sides_[i];
+  for (size_t i = 0; i < pairs_.size(); ++i)
+    pairs_[i] += other.pairs_[i];
+}
+
+void ClueHistogram::print_json(std::ostream& ostream) const {
+  const int values = size_ + 1;
+  uint64_t given = 0;
+  uint64_t ones = 0;
+  uint64_t highest = 0;
+  ostream << "{\"size\": " << size_ << ", \"puzzles\": " << puzzles_ << ", \"sides\": {";
+  for (int side = 0; side < 4; ++side) {
+    const uint64_t* counts = &sides_[side * values];
+    ostream << (side > 0 ? ", " : "") << "\"" << SIDE_NAMES[side] << "\": [";
+    for (int value = 0; value <= size_; ++value)
+      ostream << (value > 0 ? ", " : "") << counts[value];
+    ostream << "]";
+    for (int value = 1; value <= size_; ++value)
+      given += counts[value];
+    ones += counts[1];
+    highest += counts[size_];
+  }
+  ostream << "}, \"share_1\": " << (given > 0 ? double(ones) / given : 0)
+          << ", \"share_n\": " << (given > 0 ? double(highest) / given : 0)
+          << ", \"correlation\": {\"top_bottom\": ";
+  print_correlation(ostream, correlation(&pairs_[0], size_));
+  ostream << ", \"left_right\": ";
+  print_correlation(ostream, correlation(&pairs_[values * values], size_));
+  ostream << "}}";
+}
+
+int run_clue_stats(const ProgramOptions& options) {
+  const StatsOptions& stats_options = options.stats_options;
+  const int threads = resolve_thread_count(options.create_options.pipeline.generator_threads);
+  std::vector<std::map<int, ClueHistogram>> histograms(threads);
+
+  const auto start = std::chrono::steady_clock::now();
+  if (stats_options.puzzle_file != nullptr) {
+    const std::optional<uint64_t> total = parse_puzzle_file(
+      stats_options.puzzle_file, threads,
+      [&histograms](const int worker, const size_t, const int size, const int* clues) {
+        histograms[worker].try_emplace(size, size).first->second.add(clues);
+        return true;
+      });
+    if (!total.has_value())
+      return EXIT_FAILURE;
+  } else if (!generate_histograms(options, threads, histograms)) {
+    return EXIT_FAILURE;
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  // Merge the histograms of all threads, by size.
+  std::map<int, ClueHistogram> merged;
+  for (const std::map<int, ClueHistogram>& worker : histograms) {
+    for (const auto& [size, histogram] : worker)
+      merged.try_emplace(size, size).first->second.merge(histogram);
+  }
+
+  std::ofstream out{options.puzzle_output_file, std::ios::out};
+  out << std::fixed << std::setprecision(6);
+  out << "{" << std::endl << "  \"source\": \"";
+  if (stats_options.puzzle_file != nullptr)
+    print_json_string(out, stats_options.puzzle_file);
+  else
+    out << create_mode_name(options.create_options.mode);
+  out << "\"," << std::endl << "  \"seconds\": " << elapsed.count() << "," << std::endl
+      << "  \"sizes\": [" << std::endl;
+  for (auto i = merged.begin(); i != merged.end(); ++i) {
+    out << "    ";
+    i->second.print_json(out);
+    out << (std::next(i) != merged.end() ? "," : "") << std::endl;
+  }
+  out << "  ]" << std::endl << "}" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CLUE_STATS_H
+#define CLUE_STATS_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "options.h"
+
+// Histograms of the clues of many puzzles of one size: how often each
+// value appears on each side, and how often each pair of values
+// appears at the two ends of a line. A value of zero counts missing
+// clues.
+class ClueHistogram {
+ public:
+  explicit ClueHistogram(const int size);
+
+  // Counts the 4 * size clues of a puzzle, laid out as in
+  // `Puzzle::clues()`.
+  void add(const int* clues);
+
+  // Adds the counts of another histogram of the same size.
+  void merge(const ClueHistogram& other);
+
+  // Prints a JSON object summarizing the counts.
+  void print_json(std::ostream& ostream) const;
+
+ private:
+  int size_;
+  uint64_t puzzles_ = 0;
+  // Indexed by side (top, bottom, left, right) and value.
+  std::vector<uint64_t> sides_;
+  // Indexed by axis (columns, then rows), first value and second
+  // value, for the top-bottom and left-right pairs.
+  std::vector<uint64_t> pairs_;
+};
+
+// Entry point for the --clue-stats program mode. Returns a value
+// compatible with 'man 3 exit'.
+int run_clue_stats(const ProgramOptions& options);
+
+#endif
@@ -19,22 +19,34 @@
 #include "create.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <random>
 #include <optional>
 
+#include "alloc_stats.h"
+#include "bitboard.h"
 #include "board.h"
+#include "create_bulk.h"
 #include "create_random.h"
+#include "dlx.h"
 #include "options.h"
 #include "puzzle.h"
+#include "trace.h"
 
 // How many random iterations we should perform while shuffling.
 constexpr long RANDOM_SHUFFLES = 100000;
 
 std::optional<Board> create_shuffle_board(const uint16_t board_size, std::mt19937& generator) {
-  // Create a board.
-  Board b{board_size, BoardInitializer::DIAGONAL_INCREASING};
+  Board b{board_size};
+  if (!fill_shuffle_board(b, generator))
+    return std::nullopt;
+  return b;
+}
 
+// Shuffles any board that supports swapping rows and columns.
+template <typename B>
+bool shuffle_board(B& b, std::mt19937& generator) {
   // Create the distributions that we will use to choose whether to
   // swap rows and columns, and which specific indices to swap.
   std::bernoulli_distribution row_column_chooser{0.5};
@@ -47,46 +59,162 @@ std::optional<Board> create_shuffle_board(const uint16_t board_size, std::mt1993
       // Swap rows
       if (!b.swap_rows(first, second)) {
         std::cerr << "Failed to swap rows {" << first << ", " << second << "}" << std::endl;
-        return std::nullopt;
+        return false;
       }
     } else {
       // Swap columns
       if (!b.swap_columns(first, second)) {
         std::cerr << "Failed to swap columns {" << first << ", " << second << "}" << std::endl;
-        return std::nullopt;
+        return false;
       }
     }
   }
 
+  return true;
+}
+
+bool fill_shuffle_board(Board& b, std::mt19937& generator) {
+  // Start from a valid board.
+  b.reset(BoardInitializer::DIAGONAL_INCREASING);
+
+  // Small boards are shuffled as bitboards, where a swap is a few
+  // masked shifts, and give the same result.
+  std::optional<BitBoard> bits = BitBoard::from_board(b);
+  if (!bits.has_value())
+    return shuffle_board(b, generator);
+  if (!shuffle_board(*bits, generator))
+    return false;
+  bits->copy_to(b);
+  return true;
+}
+
+std::optional<Board> run_creation_algorithm(const CreateMode mode, const uint16_t board_size,
+                                            std::mt19937& generator) {
+  TraceScope trace{"generate"};
+  AllocPhaseScope alloc_phase{AllocPhase::GENERATION};
+  Board b{board_size};
+  if (!fill_board(mode, b, generator))
+    return std::nullopt;
   return b;
 }
 
-std::optional<Board> choose_creation_algorithm(const ProgramOptions& options) {
-  // Create and seed a random number generator
-  std::mt19937 generator;
-  if (options.create_options.seed > 0) {
-    generator.seed(options.create_options.seed);
-  } else {
-    auto seed = time(NULL);
-    std::cout << "Using seed: " << seed << std::endl;
-    generator.seed(seed);
+std::optional<Board> run_completion_algorithm(const CreateMode mode, const Board& partial,
+                                              std::mt19937& generator) {
+  TraceScope trace{"complete"};
+  AllocPhaseScope alloc_phase{AllocPhase::GENERATION};
+  switch (mode) {
+  case CreateMode::RANDOM:
+    return complete_random_board(partial, generator);
+  case CreateMode::DLX:
+  case CreateMode::UNSPECIFIED:
+    return complete_board(partial, generator);
+  case CreateMode::SHUFFLE:
+    break;
   }
+  std::cerr << "ERROR: cannot complete boards with the '" << create_mode_name(mode)
+            << "' creation mode" << std::endl;
+  return std::nullopt;
+}
 
-  // Choose creation algorithm based on options
-  switch (options.create_options.mode) {
+bool fill_board(const CreateMode mode, Board& b, std::mt19937& generator) {
+  AllocPhaseScope alloc_phase{AllocPhase::GENERATION};
+  switch (mode) {
   case CreateMode::SHUFFLE:
-    return create_shuffle_board(options.board_size, generator);
+    return fill_shuffle_board(b, generator);
   case CreateMode::RANDOM:
-    return create_random_board(options.board_size, generator);
+    return fill_random_board(b, generator);
+  case CreateMode::DLX:
+    return fill_dlx_board(b, generator);
   case CreateMode::UNSPECIFIED:
     std::cerr << "ERROR: invalid creation mode" << std::endl;
-    return std::nullopt;
+    return false;
   }
   std::cerr << "FATAL: invalid creation mode" << std::endl;
+  return false;
+}
+
+const char* create_mode_name(const CreateMode mode) {
+  switch (mode) {
+  case CreateMode::SHUFFLE:
+    return "shuffle";
+  case CreateMode::RANDOM:
+    return "random";
+  case CreateMode::DLX:
+    return "dlx";
+  case CreateMode::UNSPECIFIED:
+    break;
+  }
+  return "unspecified";
+}
+
+std::optional<CreateMode> parse_create_mode(const char* name) {
+  for (const CreateMode mode : {CreateMode::SHUFFLE, CreateMode::RANDOM, CreateMode::DLX}) {
+    if (strcmp(name, create_mode_name(mode)) == 0)
+      return mode;
+  }
   return std::nullopt;
 }
 
+std::mt19937 make_generator(const uint64_t seed) {
+  if (seed <= UINT32_MAX)
+    return std::mt19937{uint32_t(seed)};
+  std::seed_seq sequence{uint32_t(seed), uint32_t(seed >> 32)};
+  return std::mt19937{sequence};
+}
+
+uint32_t resolve_seed(const CreateOptions& options, std::ostream& ostream) {
+  if (options.seed > 0)
+    return options.seed;
+
+  auto seed = time(NULL);
+  ostream << "Using seed: " << seed << std::endl;
+  return seed;
+}
+
+std::optional<Board> choose_creation_algorithm(const ProgramOptions& options) {
+  TraceScope trace{"choose_creation_algorithm"};
+  const CreateOptions& create_options = options.create_options;
+  if (create_options.checkpoint_file != nullptr) {
+    // When resuming, the generator state comes from the checkpoint.
+    std::mt19937 generator;
+    if (!create_options.resume)
+      generator.seed(resolve_seed(create_options));
+    TraceScope trace_generate{"generate"};
+    AllocPhaseScope alloc_phase{AllocPhase::GENERATION};
+    Board b{options.board_size};
+    if (!fill_random_board(b, generator,
+                           RandomCheckpoint{create_options.checkpoint_file, create_options.resume}))
+      return std::nullopt;
+    return b;
+  }
+
+  // Create and seed a random number generator
+  std::mt19937 generator{resolve_seed(create_options)};
+
+  // Choose creation algorithm based on options
+  return run_creation_algorithm(options.create_options.mode, options.board_size, generator);
+}
+
 int create_board(const ProgramOptions& options) {
+  const CreateOptions& create_options = options.create_options;
+  if (create_options.resume && create_options.checkpoint_file == nullptr) {
+    std::cerr << "ERROR: no checkpoint file to resume from (-K/--checkpoint)" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (create_options.checkpoint_file != nullptr &&
+      (create_options.mode != CreateMode::RANDOM || create_options.count > 1 ||
+       create_options.shard_count > 0 || create_options.augment ||
+       create_options.unique_only || create_options.difficulty.min != Difficulty::UNSPECIFIED)) {
+    std::cerr << "ERROR: checkpoints are only supported when creating a single random board"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (options.create_options.count > 1 || options.create_options.unique_only ||
+      options.create_options.shard_count > 0 || options.create_options.augment ||
+      options.create_options.difficulty.min != Difficulty::UNSPECIFIED)
+    return create_boards_in_bulk(options);
+
   std::optional<Board> b = choose_creation_algorithm(options);
   if (!b.has_value()) {
     std::cerr << "ERROR: something went wrong while creating the board" << std::endl;
@@ -95,13 +223,21 @@ int create_board(const ProgramOptions& options) {
 
   // Print board to the desired location.
   {
+    TraceScope trace{"write_board"};
+    AllocPhaseScope alloc_phase{AllocPhase::OUTPUT};
     std::ofstream out{options.board_output_file, std::ios::out};
     b->print(out);
   }
 
   // Generate puzzle and print to the desired location.
-  Puzzle p{*b};
+  const Puzzle p = [&b] {
+    TraceScope trace{"clues"};
+    AllocPhaseScope alloc_phase{AllocPhase::CLUES};
+    return Puzzle{*b};
+  }();
   {
+    TraceScope trace{"write_puzzle"};
+    AllocPhaseScope alloc_phase{AllocPhase::OUTPUT};
     std::ofstream out{options.puzzle_output_file, std::ios::out};
     p.print(out);
   }
@@ -19,8 +19,57 @@
 #ifndef CREATE_H
 #define CREATE_H
 
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+
+#include "board.h"
 #include "options.h"
 
+// Creates a board of the given size by randomly shuffling rows and
+// columns of a valid board.
+std::optional<Board> create_shuffle_board(const uint16_t board_size, std::mt19937& generator);
+
+// Same as create_shuffle_board(), but overwrites an existing board
+// instead of allocating a new one. Returns false on failure.
+bool fill_shuffle_board(Board& b, std::mt19937& generator);
+
+// Creates a board with the given creation mode, drawing randomness
+// from the provided generator.
+std::optional<Board> run_creation_algorithm(const CreateMode mode, const uint16_t board_size,
+                                            std::mt19937& generator);
+
+// Completes a partial board, where zeros mark the free cells, with the
+// search of the given creation mode: 'random' or 'dlx' (the default).
+// Returns nothing if the board cannot be completed.
+std::optional<Board> run_completion_algorithm(const CreateMode mode, const Board& partial,
+                                              std::mt19937& generator);
+
+// Overwrites an existing board with a new one, created with the given
+// creation mode. Returns false on failure.
+bool fill_board(const CreateMode mode, Board& b, std::mt19937& generator);
+
+// Returns the name of a creation mode, as accepted by --create.
+const char* create_mode_name(const CreateMode mode);
+
+// Parses the name of a creation mode.
+std::optional<CreateMode> parse_create_mode(const char* name);
+
+// Returns a generator for a 64-bit seed. Seeds that fit in 32 bits
+// seed the generator directly, so they create the same boards as
+// everywhere else.
+std::mt19937 make_generator(const uint64_t seed);
+
+// Returns the seed selected by the provided options. If none was
+// selected, picks one based on the current time and prints it to
+// `ostream`.
+uint32_t resolve_seed(const CreateOptions& options, std::ostream& ostream = std::cout);
+
+// Creates a board using the algorithm and seed selected by the
+// provided options.
+std::optional<Board> choose_creation_algorithm(const ProgramOptions& options);
+
 // Creates a board given the provided options. Returns a value
 // compatible with 'man 3 exit'.
 int create_board(const ProgramOptions& options);
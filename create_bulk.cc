@@ -0,0 +1,412 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "create_bulk.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "alloc_stats.h"
+#include "board.h"
+#include "bounded_queue.h"
+#include "cdcl.h"
+#include "create.h"
+#include "options.h"
+#include "portfolio.h"
+#include "puzzle.h"
+#include "rating.h"
+#include "shard.h"
+#include "solve.h"
+#include "symmetry.h"
+#include "text_format.h"
+#include "trace.h"
+
+namespace {
+
+// How many boards each worker thread may have in flight, between
+// being claimed by a generator and being printed.
+constexpr uint64_t IN_FLIGHT_PER_THREAD = 16;
+
+// How much formatted text the writer collects before writing it out.
+constexpr size_t OUTPUT_BATCH_BYTES = 64 * 1024;
+
+// A board travelling through the pipeline.
+struct Item {
+  uint64_t sequence;
+  uint64_t seed;
+  std::optional<Board> board;
+  std::optional<Puzzle> puzzle;
+  // Cleared by the filter stage to drop the puzzle.
+  bool keep = true;
+};
+
+// A null item marks the end of the stream.
+using ItemQueue = BoundedQueue<std::unique_ptr<Item>>;
+
+struct Pipeline {
+  Pipeline(const ProgramOptions& options, const uint64_t window)
+    : options(options), window(window), generated(window), clued(window), filtered(window) {}
+
+  const ProgramOptions& options;
+  uint64_t base_seed = 0;
+  // Generators stop at this sequence number.
+  uint64_t limit = 0;
+  // How far ahead of the writer the generators may go.
+  const uint64_t window;
+
+  ItemQueue generated;
+  ItemQueue clued;
+  ItemQueue filtered;
+
+  std::atomic<uint64_t> next_sequence{0};
+  std::atomic<uint64_t> next_to_write{0};
+  // Set by the writer when it needs no more boards.
+  std::atomic<bool> stop{false};
+
+  // Used by the filter stage with --portfolio.
+  PortfolioOptions portfolio_options;
+  PortfolioStats portfolio_stats;
+
+  // Used by the filter stage with --difficulty.
+  std::atomic<uint64_t> rated{0};
+  std::atomic<uint64_t> too_easy{0};
+  std::atomic<uint64_t> too_hard{0};
+
+  std::vector<std::thread> threads;
+};
+
+// Starts the worker threads of a stage. Once all of them return, the
+// last one sends an end marker to each consumer of the next stage.
+void start_stage(Pipeline& pipeline, const int thread_count, ItemQueue& output,
+                 const int consumers, const std::function<void()>& body) {
+  auto remaining = std::make_shared<std::atomic<int>>(thread_count);
+  for (int i = 0; i < thread_count; ++i) {
+    pipeline.threads.emplace_back([remaining, &output, consumers, body] {
+      body();
+      if (remaining->fetch_sub(1) == 1) {
+        for (int j = 0; j < consumers; ++j)
+          output.push(nullptr);
+      }
+    });
+  }
+}
+
+void generate(Pipeline& pipeline) {
+  const CreateOptions& create_options = pipeline.options.create_options;
+  while (true) {
+    const uint64_t sequence = pipeline.next_sequence.fetch_add(1);
+    if (sequence >= pipeline.limit)
+      break;
+    // Do not run too far ahead of the writer, which has to hold every
+    // board that arrives out of order. The writer wakes us up as it
+    // advances, and once more when it stops.
+    uint64_t next_to_write = pipeline.next_to_write.load(std::memory_order_acquire);
+    while (sequence >= next_to_write + pipeline.window &&
+           !pipeline.stop.load(std::memory_order_relaxed)) {
+      pipeline.next_to_write.wait(next_to_write, std::memory_order_acquire);
+      next_to_write = pipeline.next_to_write.load(std::memory_order_acquire);
+    }
+    if (pipeline.stop.load(std::memory_order_relaxed))
+      break;
+
+    auto item = std::make_unique<Item>();
+    item->sequence = sequence;
+    item->seed = pipeline.base_seed + sequence;
+    std::mt19937 generator = make_generator(item->seed);
+    std::optional<Board> b = run_creation_algorithm(create_options.mode, pipeline.options.board_size,
+                                                    generator);
+    if (b.has_value())
+      item->board.emplace(std::move(*b));
+    pipeline.generated.push(std::move(item));
+  }
+}
+
+void compute_puzzles(Pipeline& pipeline) {
+  while (std::unique_ptr<Item> item = pipeline.generated.pop()) {
+    if (item->board.has_value()) {
+      TraceScope trace{"clues"};
+      AllocPhaseScope alloc_phase{AllocPhase::CLUES};
+      item->puzzle.emplace(*item->board);
+    }
+    pipeline.clued.push(std::move(item));
+  }
+}
+
+// Rates a puzzle and counts it if it falls outside the band. Returns
+// whether it is within.
+bool filter_difficulty(Pipeline& pipeline, const Puzzle& puzzle, std::vector<int>& clues,
+                       std::vector<CandidateMask>& workspace, bool* guessed) {
+  const int size = puzzle.size();
+  std::copy(puzzle.top().begin(), puzzle.top().end(), clues.begin());
+  std::copy(puzzle.bottom().begin(), puzzle.bottom().end(), clues.begin() + size);
+  std::copy(puzzle.left().begin(), puzzle.left().end(), clues.begin() + 2 * size);
+  std::copy(puzzle.right().begin(), puzzle.right().end(), clues.begin() + 3 * size);
+
+  const DifficultyBand& band = pipeline.options.create_options.difficulty;
+  Rating rating;
+  const bool in_band = rate_clues(size, clues.data(), band, workspace.data(),
+                                  workspace.size() * sizeof(CandidateMask), &rating);
+  pipeline.rated.fetch_add(1, std::memory_order_relaxed);
+  if (!in_band)
+    (rating.difficulty < band.min ? pipeline.too_easy : pipeline.too_hard)
+      .fetch_add(1, std::memory_order_relaxed);
+  *guessed = rating.guessed;
+  return in_band;
+}
+
+void filter_unique(Pipeline& pipeline) {
+  SolverOptions solver_options;
+  solver_options.max_solutions = 2;
+  solver_options.cancel = &pipeline.stop;
+  solver_options.backend = pipeline.options.solver_backend;
+  const bool portfolio = pipeline.options.create_options.portfolio;
+  const int size = pipeline.options.board_size;
+  const bool rate = pipeline.options.create_options.difficulty.min != Difficulty::UNSPECIFIED;
+  std::vector<int> clues(rate ? 4 * size : 0);
+  std::vector<CandidateMask> workspace(
+    rate ? SolverState::workspace_size(size) / sizeof(CandidateMask) + 1 : 0);
+  while (std::unique_ptr<Item> item = pipeline.clued.pop()) {
+    if (item->puzzle.has_value() && !pipeline.stop.load(std::memory_order_relaxed)) {
+      TraceScope trace{"filter"};
+      // Puzzles that the rules solve are unique; the others still
+      // need a search.
+      bool guessed = true;
+      if (rate && !filter_difficulty(pipeline, *item->puzzle, clues, workspace, &guessed)) {
+        item->keep = false;
+      } else if (guessed) {
+        SolveStatus status;
+        SolverStats stats;
+        if (portfolio) {
+          solve_portfolio(*item->puzzle, pipeline.portfolio_options, &status, &stats,
+                          &pipeline.portfolio_stats);
+        } else {
+          solve_puzzle(*item->puzzle, solver_options, &status, &stats);
+        }
+        item->keep = status == SolveStatus::SOLVED && stats.solutions == 1;
+      }
+    }
+    pipeline.filtered.push(std::move(item));
+  }
+}
+
+// Formats a board and its puzzle, after a blank line unless they are
+// the first ones.
+void print_puzzle(const Board& board, const Puzzle& puzzle, const bool separate,
+                  TextFormatter& board_text, TextFormatter& puzzle_text) {
+  if (separate) {
+    board_text.append_newline();
+    puzzle_text.append_newline();
+  }
+  board_text.append(board);
+  puzzle_text.append(puzzle);
+}
+
+// Returns the distinct rotations and reflections of a board, starting
+// with the board itself. Each comes with its puzzle, whose clues are
+// permuted from the original ones instead of being computed again.
+std::vector<std::pair<Board, Puzzle>> augment(const Board& board, const Puzzle& puzzle) {
+  std::vector<std::pair<Board, Puzzle>> images;
+  images.reserve(SYMMETRIES);
+  for (int t = 0; t < SYMMETRIES; ++t) {
+    Board image = transform_board(t, board);
+    // Symmetric boards map to themselves under some transforms.
+    const bool duplicate = std::any_of(images.begin(), images.end(),
+                                       [&image](const auto& other) { return other.first == image; });
+    if (!duplicate)
+      images.emplace_back(std::move(image), transform_puzzle(t, puzzle));
+  }
+  return images;
+}
+
+// Without filtering, generation gets all the cores. With it, the
+// generators and the filters share them, so that neither stage takes
+// cores away from the other.
+void default_stage_threads(const bool filter, int* generator_threads, int* filter_threads) {
+  const int cores = resolve_thread_count(0);
+  if (!filter) {
+    *generator_threads = cores;
+    *filter_threads = 0;
+    return;
+  }
+  *generator_threads = std::max(1, cores / 2);
+  *filter_threads = std::max(1, cores - *generator_threads);
+}
+
+}  // namespace
+
+int create_boards_in_bulk(const ProgramOptions& options) {
+  const CreateOptions& create_options = options.create_options;
+  const PipelineOptions& threads = create_options.pipeline;
+  const bool rate = create_options.difficulty.min != Difficulty::UNSPECIFIED;
+  const bool filter = create_options.unique_only || rate;
+  int default_generators;
+  int default_filters;
+  default_stage_threads(filter, &default_generators, &default_filters);
+  const int generator_threads = threads.generator_threads > 0 ?
+    threads.generator_threads : default_generators;
+  const int clue_threads = threads.clue_threads > 0 ? threads.clue_threads : 1;
+  const int filter_threads = !filter ? 0 :
+    threads.filter_threads > 0 ? threads.filter_threads : default_filters;
+
+  const int max_size = options.solver_backend == SolverBackend::CDCL ?
+    MAX_CDCL_SIZE : MAX_SOLVER_SIZE;
+  if (filter && !create_options.portfolio && options.board_size > max_size) {
+    std::cerr << "ERROR: cannot check uniqueness for boards larger than " << max_size << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (create_options.augment && create_options.shard_count > 0) {
+    std::cerr << "ERROR: cannot augment sharded records, which are keyed by seed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (rate && options.board_size > MAX_SOLVER_SIZE) {
+    std::cerr << "ERROR: cannot rate boards larger than " << MAX_SOLVER_SIZE << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const int worker_threads = generator_threads + clue_threads + filter_threads;
+  Pipeline pipeline{options, IN_FLIGHT_PER_THREAD * worker_threads};
+  const bool sharded = create_options.shard_count > 0;
+  // A shard must create the same boards on every run, so its seeds do
+  // not depend on the time.
+  pipeline.base_seed = sharded ?
+    shard_first_seed(create_options.shard_index, create_options.shard_count) + create_options.seed :
+    resolve_seed(create_options);
+  // Without filtering, every board is printed, so there is no need
+  // to generate more than requested. Augmenting prints several
+  // puzzles per board, and the writer stops the generators once it
+  // has enough.
+  pipeline.limit = filter || create_options.augment ? UINT64_MAX : create_options.count;
+  pipeline.portfolio_options.max_solutions = 2;
+  pipeline.portfolio_options.cancel = &pipeline.stop;
+
+  std::ofstream board_out{options.board_output_file, std::ios::out};
+  if (!board_out.is_open()) {
+    std::cerr << "ERROR: cannot open solution file: " << options.board_output_file << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::ofstream puzzle_out{options.puzzle_output_file, std::ios::out};
+  if (!puzzle_out.is_open()) {
+    std::cerr << "ERROR: cannot open output file: " << options.puzzle_output_file << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Wire the stages. Without filtering, the clue stage feeds the
+  // writer directly.
+  ItemQueue& writer_input = filter_threads > 0 ? pipeline.filtered : pipeline.clued;
+  start_stage(pipeline, generator_threads, pipeline.generated, clue_threads,
+              [&pipeline] { generate(pipeline); });
+  start_stage(pipeline, clue_threads, pipeline.clued, filter_threads > 0 ? filter_threads : 1,
+              [&pipeline] { compute_puzzles(pipeline); });
+  if (filter_threads > 0) {
+    start_stage(pipeline, filter_threads, pipeline.filtered, 1,
+                [&pipeline] { filter_unique(pipeline); });
+  }
+
+  // The writer runs on this thread, and restores the seed order.
+  std::vector<std::unique_ptr<Item>> pending(pipeline.window);
+  TextFormatter board_text;
+  TextFormatter puzzle_text;
+  uint32_t written = 0;
+  bool failed = false;
+  // Writes out the formatted text. On an error, reports it and stops
+  // the pipeline, as manifest jobs do.
+  auto flush = [&](const bool close) {
+    bool boards_ok = board_text.write(board_out);
+    bool puzzles_ok = puzzle_text.write(puzzle_out);
+    if (close) {
+      board_out.close();
+      puzzle_out.close();
+      boards_ok = boards_ok && !board_out.fail();
+      puzzles_ok = puzzles_ok && !puzzle_out.fail();
+    }
+    if (!puzzles_ok)
+      std::cerr << "ERROR: cannot write output file: " << options.puzzle_output_file << std::endl;
+    else if (!boards_ok)
+      std::cerr << "ERROR: cannot write solution file: " << options.board_output_file << std::endl;
+    if (!boards_ok || !puzzles_ok) {
+      failed = true;
+      pipeline.stop.store(true);
+    }
+  };
+  while (std::unique_ptr<Item> item = writer_input.pop()) {
+    const uint64_t slot = item->sequence % pipeline.window;
+    pending[slot] = std::move(item);
+
+    uint64_t next = pipeline.next_to_write.load(std::memory_order_relaxed);
+    while (pending[next % pipeline.window] != nullptr) {
+      std::unique_ptr<Item> ready = std::move(pending[next % pipeline.window]);
+      if (!pipeline.stop.load(std::memory_order_relaxed)) {
+        if (!ready->board.has_value()) {
+          std::cerr << "ERROR: something went wrong while creating the board with seed "
+                    << ready->seed << std::endl;
+          failed = true;
+          pipeline.stop.store(true);
+        } else if (ready->keep) {
+          TraceScope trace{"write"};
+          AllocPhaseScope alloc_phase{AllocPhase::OUTPUT};
+          if (sharded) {
+            write_record(puzzle_out, ready->seed, create_options.mode, *ready->board,
+                         *ready->puzzle);
+            ++written;
+          } else if (create_options.augment) {
+            for (const auto& [board, puzzle] : augment(*ready->board, *ready->puzzle)) {
+              if (written == create_options.count)
+                break;
+              print_puzzle(board, puzzle, written++ > 0, board_text, puzzle_text);
+            }
+          } else {
+            print_puzzle(*ready->board, *ready->puzzle, written++ > 0, board_text, puzzle_text);
+          }
+          if (board_text.size() + puzzle_text.size() >= OUTPUT_BATCH_BYTES ||
+              (sharded && !puzzle_out.good()))
+            flush(/*close=*/false);
+          if (written == create_options.count)
+            pipeline.stop.store(true);
+        }
+      }
+      pipeline.next_to_write.store(++next, std::memory_order_release);
+      pipeline.next_to_write.notify_all();
+    }
+  }
+
+  if (!failed)
+    flush(/*close=*/true);
+
+  for (std::thread& t : pipeline.threads)
+    t.join();
+
+  if (filter_threads > 0 && create_options.portfolio)
+    pipeline.portfolio_stats.print(std::cerr, pipeline.portfolio_options);
+  if (rate) {
+    std::cerr << "Rated " << pipeline.rated.load() << " puzzles: " << pipeline.too_easy.load()
+              << " too easy, " << pipeline.too_hard.load() << " too hard" << std::endl;
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,31 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CREATE_BULK_H
+#define CREATE_BULK_H
+
+#include "options.h"
+
+// Creates `options.create_options.count` puzzles and prints them, in
+// seed order, separated by empty lines. Generation, clue computation,
+// filtering and output run as separate stages, each on its own
+// threads, connected by bounded queues. Returns a value compatible
+// with 'man 3 exit'.
+int create_boards_in_bulk(const ProgramOptions& options);
+
+#endif
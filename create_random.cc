@@ -19,11 +19,19 @@
 #include "create_random.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
 #include <random>
 #include <optional>
 #include <set>
-#include <stack>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "board.h"
 
@@ -64,6 +72,183 @@ RandomGenerationStep generate_step(const uint16_t row, const uint16_t column,
 
 // After how many iterations we should print a status update on the screen.
 constexpr long ITERATIONS_PRINT_STATE = 1000000L;
+
+constexpr char CHECKPOINT_MAGIC[8] = {'S', 'K', 'Y', 'R', 'A', 'N', 'D', '1'};
+
+// The fixed-size part of a checkpoint. It is followed by the
+// generator state in its textual form, by one value per cell of the
+// stack, and by the remaining legal values of each step, each list
+// preceded by its length. Values are stored as 16-bit integers.
+//
+// The leftover trackers are not stored: they always hold the values
+// missing from the board in each row and column, and are rebuilt from
+// it.
+struct CheckpointHeader {
+  char magic[8];
+  uint32_t size;
+  uint32_t depth;
+  uint64_t iterations;
+  uint64_t generator_length;
+};
+
+// Writes `data` to a new file at `path`, and flushes it to the disk.
+bool write_synced(const std::string& path, const std::string& data) {
+  const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+  size_t written = 0;
+  while (written < data.size()) {
+    const ssize_t n = write(fd, data.data() + written, data.size() - written);
+    if (n < 0) {
+      close(fd);
+      return false;
+    }
+    written += n;
+  }
+  const bool synced = fsync(fd) == 0;
+  return close(fd) == 0 && synced;
+}
+
+// Flushes the entries of the directory holding `path`, so that a
+// rename into it survives a crash.
+bool sync_parent_directory(const std::string& path) {
+  const size_t slash = path.rfind('/');
+  const std::string directory = slash == std::string::npos ? "." :
+    slash == 0 ? "/" : path.substr(0, slash);
+  const int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0)
+    return false;
+  const bool synced = fsync(fd) == 0;
+  close(fd);
+  return synced;
+}
+
+// Writes the search state to `path`, atomically and durably: the state
+// goes to a temporary file first, which is synced to the disk and then
+// replaces the checkpoint.
+bool save_checkpoint(const char* path, const Board& b,
+                     const std::vector<RandomGenerationStep>& stack, const long iterations,
+                     const std::mt19937& generator) {
+  std::ostringstream generator_state;
+  generator_state << generator;
+  const std::string state = generator_state.str();
+
+  std::string data;
+  auto append = [&data](const void* p, const size_t n) {
+    data.append(static_cast<const char*>(p), n);
+  };
+  CheckpointHeader header;
+  memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+  header.size = b.size();
+  header.depth = stack.size();
+  header.iterations = iterations;
+  header.generator_length = state.size();
+  append(&header, sizeof(header));
+  append(state.data(), state.size());
+  for (const RandomGenerationStep& step : stack) {
+    const uint16_t value = b.at(step.row, step.column);
+    append(&value, sizeof(value));
+  }
+  for (const RandomGenerationStep& step : stack) {
+    const uint16_t count = step.legal_values.size();
+    append(&count, sizeof(count));
+    for (const int v : step.legal_values) {
+      const uint16_t value = v;
+      append(&value, sizeof(value));
+    }
+  }
+
+  const std::string temporary = std::string(path) + ".tmp";
+  if (!write_synced(temporary, data)) {
+    std::cerr << "ERROR: cannot write checkpoint file: " << temporary << std::endl;
+    return false;
+  }
+  if (std::rename(temporary.c_str(), path) != 0 || !sync_parent_directory(path)) {
+    std::cerr << "ERROR: cannot replace checkpoint file: " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Restores the search state saved by save_checkpoint(). The board must
+// have the size of the saved one, and is overwritten.
+bool load_checkpoint(const char* path, Board& b, std::vector<RandomGenerationStep>& stack,
+                     long& iterations, std::mt19937& generator) {
+  std::ifstream in{path, std::ios::in | std::ios::binary};
+  CheckpointHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+    std::cerr << "ERROR: not a checkpoint file: " << path << std::endl;
+    return false;
+  }
+  const int size = b.size();
+  if (header.size != uint32_t(size)) {
+    std::cerr << "ERROR: the checkpoint is for boards of size " << header.size << std::endl;
+    return false;
+  }
+  auto corrupted = [path] {
+    std::cerr << "ERROR: corrupted checkpoint file: " << path << std::endl;
+    return false;
+  };
+  if (header.depth < 1 || header.depth > uint32_t(size * size) || header.generator_length > (1 << 20))
+    return corrupted();
+  std::string state(header.generator_length, '\0');
+  if (!in.read(state.data(), state.size()))
+    return corrupted();
+  std::istringstream generator_state{state};
+  if (!(generator_state >> generator))
+    return corrupted();
+
+  auto read_value = [&in, size](int* value, const int min) {
+    uint16_t v;
+    if (!in.read(reinterpret_cast<char*>(&v), sizeof(v)) || v < min || v > size)
+      return false;
+    *value = v;
+    return true;
+  };
+  b.reset(BoardInitializer::EMPTY);
+  stack.clear();
+  // A value that cannot be read or is out of range corrupts the whole
+  // file: the rest of the stack would be misaligned.
+  for (uint32_t i = 0; i < header.depth; ++i) {
+    int value;
+    if (!read_value(&value, 0))
+      return corrupted();
+    const uint16_t row = i / size;
+    const uint16_t column = i % size;
+    if (value != 0)
+      b.set(value, row, column);
+    stack.push_back(RandomGenerationStep{.row = row, .column = column, .legal_values = {}});
+  }
+  for (RandomGenerationStep& step : stack) {
+    int count;
+    if (!read_value(&count, 0))
+      return corrupted();
+    for (int j = 0; j < count; ++j) {
+      int value;
+      if (!read_value(&value, 1))
+        return corrupted();
+      step.legal_values.push_back(value);
+    }
+  }
+  if (in.peek() != std::ifstream::traits_type::eof())
+    // Trailing bytes: the lengths do not describe this file.
+    return corrupted();
+  iterations = header.iterations;
+  return true;
+}
+
+// Rebuilds the leftover trackers from the values on the board.
+bool rebuild_trackers(const Board& b, LeftoverTracker& rows, LeftoverTracker& columns) {
+  for (int row = 0; row < b.size(); ++row) {
+    for (int column = 0; column < b.size(); ++column) {
+      const int value = b.at(row, column);
+      if (value != 0 && (rows[row].erase(value) != 1 || columns[column].erase(value) != 1))
+        return false;
+    }
+  }
+  return true;
+}
 #ifdef NDEBUG
 constexpr bool DEBUG_FULL_STATE = false;
 #else
@@ -71,21 +256,82 @@ constexpr bool DEBUG_FULL_STATE = true;
 #endif
 
 std::optional<Board> create_random_board(const uint16_t board_size, std::mt19937& generator) {
-  // Create an empty board.
   Board b{board_size, BoardInitializer::EMPTY};
+  if (!fill_random_board(b, generator))
+    return std::nullopt;
+  return b;
+}
 
-  // Keep track of which values we have not used yet in each row and column
+// Returns the index of the first cell at or after `cell` that is not
+// fixed, or the number of cells if there is none.
+int next_free_cell(const std::vector<bool>& fixed, int cell) {
+  while (cell < int(fixed.size()) && fixed[cell])
+    ++cell;
+  return cell;
+}
+
+// How a search for a random board ended.
+enum class SearchOutcome {
+  FILLED,
+  // No values fit the free cells.
+  EXHAUSTED,
+  // The search stopped early, after reporting why.
+  INTERRUPTED,
+};
+
+// Fills the cells of `b` that are not fixed, in row-major order,
+// backtracking through random legal values. The fixed cells must
+// already be on the board.
+SearchOutcome search_random_board(Board& b, const std::vector<bool>& fixed, std::mt19937& generator,
+                         const RandomCheckpoint& checkpoint) {
+  const uint16_t board_size = b.size();
+  const int cells = board_size * board_size;
+  const int first_free = next_free_cell(fixed, 0);
+  if (first_free == cells)
+    // Nothing left to fill.
+    return b.is_valid() ? SearchOutcome::FILLED : SearchOutcome::EXHAUSTED;
+  int last_free = cells - 1;
+  while (fixed[last_free])
+    --last_free;
+
+  // Keep track of which values we have not used yet in each row and
+  // column, starting from the fixed cells.
   LeftoverTracker rows = generate_trackers(board_size);
   LeftoverTracker columns = generate_trackers(board_size);
+  if (!rebuild_trackers(b, rows, columns))
+    // The fixed cells repeat a value in a row or column.
+    return SearchOutcome::EXHAUSTED;
 
-  // Initialize the algorithm stack holding the state.
-  std::stack<RandomGenerationStep> stack;
-  stack.push(generate_step(/*row=*/0, /*column=*/0, rows, columns, generator));
+  // Initialize the algorithm stack holding the state, or restore it.
+  std::vector<RandomGenerationStep> stack;
+  long iterations = 0;
+  if (checkpoint.resume) {
+    if (!load_checkpoint(checkpoint.path, b, stack, iterations, generator))
+      return SearchOutcome::INTERRUPTED;
+    if (!rebuild_trackers(b, rows, columns)) {
+      std::cerr << "ERROR: corrupted checkpoint file: " << checkpoint.path << std::endl;
+      return SearchOutcome::INTERRUPTED;
+    }
+  } else {
+    stack.push_back(generate_step(first_free / board_size, first_free % board_size, rows, columns,
+                                  generator));
+  }
+  const long resumed_iterations = iterations;
 
   // Main random generation loop
-  long iterations = 0;
   while (!stack.empty()) {
-    RandomGenerationStep& state = stack.top();
+    // Save the state every now and then, before it changes again.
+    if (checkpoint.path != nullptr && iterations % checkpoint.interval == 0 &&
+        iterations != resumed_iterations &&
+        !save_checkpoint(checkpoint.path, b, stack, iterations, generator))
+      return SearchOutcome::INTERRUPTED;
+    if (checkpoint.max_iterations > 0 &&
+        iterations - resumed_iterations >= checkpoint.max_iterations) {
+      std::cerr << "Stopped after " << iterations << " iterations" << std::endl;
+      return SearchOutcome::INTERRUPTED;
+    }
+
+    RandomGenerationStep& state = stack.back();
 
     // Print the iteration number every now and then, for progress.
     if ((++iterations % ITERATIONS_PRINT_STATE) == 0) {
@@ -108,13 +354,13 @@ std::optional<Board> create_random_board(const uint16_t board_size, std::mt19937
       if (!r_inserted) {
         std::cerr << "FATAL: failed to insert value " << current_value << " into row "
                   << state.row << ". This should never happen." << std::endl;
-        return std::nullopt;
+        return SearchOutcome::INTERRUPTED;
       }
       auto [c_i, c_inserted] = columns[state.column].insert(current_value);
       if (!c_inserted) {
         std::cerr << "FATAL: failed to insert value " << current_value << " into column "
                   << state.column << ". This should never happen." << std::endl;
-        return std::nullopt;
+        return SearchOutcome::INTERRUPTED;
       }
     }
 
@@ -122,7 +368,7 @@ std::optional<Board> create_random_board(const uint16_t board_size, std::mt19937
     // reset it to 'empty' and go back to the previous one.
     if (state.legal_values.empty()) {
       b.clear(state.row, state.column);
-      stack.pop();
+      stack.pop_back();
       continue;
     }
 
@@ -132,38 +378,70 @@ std::optional<Board> create_random_board(const uint16_t board_size, std::mt19937
     if (!b.set(next_value, state.row, state.column)) {
       std::cerr << "FATAL: failed to insert " << next_value << " into {" << state.row << ", "
                 << state.column << "}. This should never happen." << std::endl;
-      return std::nullopt;
+      return SearchOutcome::INTERRUPTED;
     }
     if (rows[state.row].erase(next_value) != 1) {
       std::cerr << "FATAL: failed to erase value " << next_value << " from row "
                 << state.row << ". This should never happen." << std::endl;
-      return std::nullopt;
+      return SearchOutcome::INTERRUPTED;
     }
     if (columns[state.column].erase(next_value) != 1) {
       std::cerr << "FATAL: failed to erase value " << next_value << " from column "
                 << state.column << ". This should never happen." << std::endl;
-      return std::nullopt;
+      return SearchOutcome::INTERRUPTED;
     }
 
     // Are we done?
-    if (state.row == board_size - 1 && state.column == board_size - 1) {
+    const int cell = state.row * board_size + state.column;
+    if (cell == last_free) {
       // Yes, do a last sanity check and return the generated board.
       if (!b.is_valid()) {
         std::cerr << "FATAL: failed to validate a randomly generated a board. This should never happen." << std::endl;
         std::cerr << "  This is what was generated:" << std::endl;
         b.print(std::cerr);
-        return std::nullopt;
+        return SearchOutcome::INTERRUPTED;
       }
-      return b;
+      if (checkpoint.path != nullptr)
+        std::remove(checkpoint.path);
+      return SearchOutcome::FILLED;
     }
 
-    // We are not done. Prepare for the next step by moving one column
-    // to the right, or to the next row if the row is complete.
-    const int next_column = (state.column + 1) % board_size;
-    const int next_row = next_column > 0? state.row : state.row + 1;
-    stack.push(generate_step(next_row, next_column, rows, columns, generator));
+    // We are not done. Prepare for the next step by moving to the
+    // next cell that is not fixed, in row-major order.
+    const int next = next_free_cell(fixed, cell + 1);
+    stack.push_back(generate_step(next / board_size, next % board_size, rows, columns, generator));
   }
 
-  std::cerr << "FATAL: failed to randomly generate a board. This should never happen." << std::endl;
-  return std::nullopt;
+  // Every value was tried in the first free cell.
+  return SearchOutcome::EXHAUSTED;
+}
+
+bool fill_random_board(Board& b, std::mt19937& generator, const RandomCheckpoint& checkpoint) {
+  // Start from an empty board.
+  b.reset(BoardInitializer::EMPTY);
+  const SearchOutcome outcome =
+    search_random_board(b, std::vector<bool>(b.size() * b.size()), generator, checkpoint);
+  if (outcome == SearchOutcome::EXHAUSTED)
+    std::cerr << "FATAL: failed to randomly generate a board. This should never happen." << std::endl;
+  return outcome == SearchOutcome::FILLED;
+}
+
+std::optional<Board> complete_random_board(const Board& partial, std::mt19937& generator) {
+  if (!is_partial_board_feasible(partial))
+    return std::nullopt;
+  const int size = partial.size();
+  Board b{size};
+  std::vector<bool> fixed(size * size);
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column) {
+      const int value = partial.at(row, column);
+      if (value != 0) {
+        b.set(value, row, column);
+        fixed[row * size + column] = true;
+      }
+    }
+  }
+  if (search_random_board(b, fixed, generator, RandomCheckpoint{}) != SearchOutcome::FILLED)
+    return std::nullopt;
+  return b;
 }
@@ -28,4 +28,36 @@
 // Creates a board of the given size, randomly.
 std::optional<Board> create_random_board(const uint16_t board_size, std::mt19937& generator);
 
+// Where fill_random_board() saves its search state, so that an
+// interrupted run can be continued.
+struct RandomCheckpoint {
+  // If not null, the state is saved there every now and then, and
+  // the file is removed once the board is complete.
+  const char* path = nullptr;
+  // Whether to start from the state saved at `path`, instead of from
+  // an empty board. The generator state is restored too, so that the
+  // result is the same as that of an uninterrupted run.
+  bool resume = false;
+  // How many iterations of the search pass between two saves.
+  long interval = 10000000L;
+  // If positive, the search gives up after this many iterations (since
+  // the start or the resume), leaving the last saved state to resume
+  // from later.
+  long max_iterations = 0;
+};
+
+// Same as create_random_board(), but overwrites an existing board
+// instead of allocating a new one. Returns false on failure, or when
+// `checkpoint.max_iterations` runs out.
+bool fill_random_board(Board& b, std::mt19937& generator,
+                       const RandomCheckpoint& checkpoint = RandomCheckpoint{});
+
+// Completes a partial board, where zeros mark the free cells, with the
+// same search as create_random_board(): the leftover values of each
+// row and column start from the filled cells, and only the free cells
+// are searched. Returns nothing if there is no completion; partial
+// boards that fail `is_partial_board_feasible()` are rejected without
+// searching.
+std::optional<Board> complete_random_board(const Board& partial, std::mt19937& generator);
+
 #endif
@@ -0,0 +1,336 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dlx.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "alloc_stats.h"
+#include "create.h"
+
+namespace {
+
+// The offsets of the arrays of a LatinSquareCover in its arena. Every
+// array is 8-byte aligned.
+struct Layout {
+  size_t nodes;
+  size_t column_size;
+  size_t stack;
+  size_t fixed;
+  size_t total;
+};
+
+size_t align_up(const size_t n) {
+  return (n + 7) & ~size_t(7);
+}
+
+template <typename Node, typename Level>
+Layout compute_layout(const int size) {
+  const size_t n = size;
+  const size_t columns = 3 * n * n;
+  Layout l;
+  l.nodes = 0;
+  l.column_size = align_up(l.nodes + (1 + columns + 3 * n * n * n) * sizeof(Node));
+  l.stack = align_up(l.column_size + (1 + columns) * sizeof(int32_t));
+  l.fixed = align_up(l.stack + n * n * sizeof(Level));
+  l.total = align_up(l.fixed + n * n * sizeof(int32_t));
+  return l;
+}
+
+}  // namespace
+
+size_t LatinSquareCover::workspace_size(const int size) {
+  return compute_layout<Node, Level>(size).total;
+}
+
+LatinSquareCover::LatinSquareCover(const int size)
+  : size_(size), storage_(workspace_size(size) / sizeof(uint64_t)) {
+  initialize(storage_.data());
+}
+
+LatinSquareCover::LatinSquareCover(const int size, void* workspace) : size_(size) {
+  initialize(workspace);
+}
+
+void LatinSquareCover::initialize(void* workspace) {
+  const Layout l = compute_layout<Node, Level>(size_);
+  char* base = static_cast<char*>(workspace);
+  nodes_ = reinterpret_cast<Node*>(base + l.nodes);
+  column_size_ = reinterpret_cast<int32_t*>(base + l.column_size);
+  stack_ = reinterpret_cast<Level*>(base + l.stack);
+  fixed_ = reinterpret_cast<int32_t*>(base + l.fixed);
+
+  const int n = size_;
+  const int columns = 3 * n * n;
+  std::fill(column_size_, column_size_ + 1 + columns, 0);
+
+  // The root and the column headers form a circular list.
+  for (int h = 0; h <= columns; ++h) {
+    nodes_[h] = Node{h == 0 ? columns : h - 1, h == columns ? 0 : h + 1, h, h, h};
+  }
+
+  // Each option is a row of three nodes, appended at the bottom of
+  // their columns.
+  auto append = [this](const int node, const int header) {
+    const int last = nodes_[header].up;
+    nodes_[node].up = last;
+    nodes_[node].down = header;
+    nodes_[node].column = header;
+    nodes_[last].down = node;
+    nodes_[header].up = node;
+    ++column_size_[header];
+  };
+  for (int row = 0; row < n; ++row) {
+    for (int column = 0; column < n; ++column) {
+      for (int v = 0; v < n; ++v) {
+        const int first = 1 + columns + 3 * ((row * n + column) * n + v);
+        append(first, 1 + row * n + column);                // (row, column)
+        append(first + 1, 1 + n * n + row * n + v);         // (row, value)
+        append(first + 2, 1 + 2 * n * n + column * n + v);  // (column, value)
+        for (int i = 0; i < 3; ++i) {
+          nodes_[first + i].left = first + (i + 2) % 3;
+          nodes_[first + i].right = first + (i + 1) % 3;
+        }
+      }
+    }
+  }
+}
+
+void LatinSquareCover::cover(const int column) {
+  Node* nodes = nodes_;
+  nodes[nodes[column].right].left = nodes[column].left;
+  nodes[nodes[column].left].right = nodes[column].right;
+  for (int i = nodes[column].down; i != column; i = nodes[i].down) {
+    for (int j = nodes[i].right; j != i; j = nodes[j].right) {
+      nodes[nodes[j].down].up = nodes[j].up;
+      nodes[nodes[j].up].down = nodes[j].down;
+      --column_size_[nodes[j].column];
+    }
+  }
+}
+
+void LatinSquareCover::uncover(const int column) {
+  Node* nodes = nodes_;
+  for (int i = nodes[column].up; i != column; i = nodes[i].up) {
+    for (int j = nodes[i].left; j != i; j = nodes[j].left) {
+      ++column_size_[nodes[j].column];
+      nodes[nodes[j].down].up = j;
+      nodes[nodes[j].up].down = j;
+    }
+  }
+  nodes[nodes[column].right].left = column;
+  nodes[nodes[column].left].right = column;
+}
+
+// Covers the columns of the other nodes in a row, whose own column is
+// already covered.
+void LatinSquareCover::select(const int node) {
+  for (int j = nodes_[node].right; j != node; j = nodes_[j].right)
+    cover(nodes_[j].column);
+}
+
+void LatinSquareCover::unselect(const int node) {
+  for (int j = nodes_[node].left; j != node; j = nodes_[j].left)
+    uncover(nodes_[j].column);
+}
+
+int LatinSquareCover::choose_column(std::mt19937* generator) const {
+  // The column with the fewest rows left, breaking ties uniformly at
+  // random.
+  int best = -1;
+  int best_size = INT32_MAX;
+  int ties = 0;
+  for (int h = nodes_[0].right; h != 0; h = nodes_[h].right) {
+    const int size = column_size_[h];
+    if (size > best_size)
+      continue;
+    if (size < best_size) {
+      best = h;
+      best_size = size;
+      ties = 1;
+      if (size == 0)
+        break;
+    } else if (generator != nullptr &&
+               std::uniform_int_distribution<int>{0, ties++}(*generator) == 0) {
+      best = h;
+    }
+  }
+  return best;
+}
+
+int LatinSquareCover::option_of(const int node) const {
+  // Every row starts with its (row, column) node.
+  const int first_row_node = 1 + 3 * size_ * size_;
+  return (node - first_row_node) / 3;
+}
+
+bool LatinSquareCover::fix(const int row, const int column, const int value) {
+  const int n = size_;
+  const int node = 1 + 3 * n * n + 3 * ((row * n + column) * n + value - 1);
+  // The option is still available only if none of its columns is
+  // covered yet.
+  for (int i = 0; i < 3; ++i) {
+    const int header = nodes_[node + i].column;
+    if (nodes_[nodes_[header].left].right != header)
+      return false;
+  }
+  cover(nodes_[node].column);
+  select(node);
+  fixed_[fixed_count_++] = node;
+  return true;
+}
+
+void LatinSquareCover::clear() {
+  while (fixed_count_ > 0) {
+    const int node = fixed_[--fixed_count_];
+    unselect(node);
+    uncover(nodes_[node].column);
+  }
+}
+
+bool LatinSquareCover::solve(std::mt19937* generator, int* cells) {
+  int depth = 0;
+  bool found = false;
+  while (true) {
+    if (nodes_[0].right == 0) {
+      found = true;
+      break;
+    }
+
+    const int column = choose_column(generator);
+    if (column_size_[column] > 0) {
+      cover(column);
+      int first = nodes_[column].down;
+      if (generator != nullptr) {
+        for (int skip = std::uniform_int_distribution<int>{0, column_size_[column] - 1}(*generator);
+             skip > 0; --skip)
+          first = nodes_[first].down;
+      }
+      select(first);
+      stack_[depth++] = Level{column, first, first};
+      continue;
+    }
+
+    // Dead end: move to the next row of the innermost level, wrapping
+    // around its column, and backtrack out of the exhausted levels.
+    bool advanced = false;
+    while (depth > 0 && !advanced) {
+      Level& level = stack_[depth - 1];
+      unselect(level.current);
+      int next = nodes_[level.current].down;
+      if (next == level.column)
+        next = nodes_[next].down;
+      if (next == level.first) {
+        uncover(level.column);
+        --depth;
+        continue;
+      }
+      level.current = next;
+      select(next);
+      advanced = true;
+    }
+    if (!advanced)
+      break;
+  }
+
+  if (found) {
+    const int n = size_;
+    auto record = [&](const int node) {
+      const int option = option_of(node);
+      cells[option / n] = option % n + 1;
+    };
+    for (int i = 0; i < fixed_count_; ++i)
+      record(fixed_[i]);
+    for (int i = 0; i < depth; ++i)
+      record(stack_[i].current);
+  }
+
+  // Leave only the fixed values in place.
+  while (depth > 0) {
+    const Level& level = stack_[--depth];
+    unselect(level.current);
+    uncover(level.column);
+  }
+  return found;
+}
+
+bool fill_dlx_board(Board& b, std::mt19937& generator) {
+  const int n = b.size();
+  LatinSquareCover cover{n};
+  std::vector<int> cells(n * n);
+  if (!cover.solve(&generator, cells.data())) {
+    std::cerr << "FATAL: failed to fill an empty board. This should never happen." << std::endl;
+    return false;
+  }
+  for (int i = 0; i < n * n; ++i)
+    b.set(cells[i], i / n, i % n);
+  return true;
+}
+
+std::optional<Board> complete_board(const Board& partial, std::mt19937& generator) {
+  if (!is_partial_board_feasible(partial))
+    return std::nullopt;
+  const int n = partial.size();
+  LatinSquareCover cover{n};
+  for (int row = 0; row < n; ++row) {
+    for (int column = 0; column < n; ++column) {
+      const int value = partial.at(row, column);
+      if (value != 0 && !cover.fix(row, column, value))
+        return std::nullopt;
+    }
+  }
+  std::vector<int> cells(n * n);
+  if (!cover.solve(&generator, cells.data()))
+    return std::nullopt;
+
+  Board b{n};
+  for (int i = 0; i < n * n; ++i)
+    b.set(cells[i], i / n, i % n);
+  return b;
+}
+
+int run_completion(const ProgramOptions& options) {
+  std::ifstream in{options.complete_options.board_file};
+  if (!in) {
+    std::cerr << "ERROR: cannot read board file: " << options.complete_options.board_file
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::optional<Board> partial = parse_board(in);
+  if (!partial.has_value()) {
+    std::cerr << "ERROR: not a valid partial board: " << options.complete_options.board_file
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937 generator{resolve_seed(options.create_options)};
+  const std::optional<Board> b =
+      run_completion_algorithm(options.create_options.mode, *partial, generator);
+  if (!b.has_value()) {
+    std::cerr << "ERROR: the board cannot be completed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  AllocPhaseScope alloc_phase{AllocPhase::OUTPUT};
+  std::ofstream out{options.puzzle_output_file, std::ios::out};
+  b->print(out);
+  return EXIT_SUCCESS;
+}
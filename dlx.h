@@ -0,0 +1,125 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DLX_H
+#define DLX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "board.h"
+#include "options.h"
+
+// Fills Latin squares with Knuth's Dancing Links, seeing the square
+// as an exact cover problem: each choice of a value for a cell covers
+// one (row, column), one (row, value) and one (column, value) pair,
+// and each pair must be covered exactly once.
+//
+// All the links live in a single arena, allocated by the constructor
+// or provided by the caller, and the search keeps its stack in the
+// same arena, so neither fixing cells nor searching allocates.
+class LatinSquareCover {
+ public:
+  // Returns the number of arena bytes needed for the given size.
+  static size_t workspace_size(const int size);
+
+  explicit LatinSquareCover(const int size);
+
+  // Lays out the arena in a caller-provided workspace of at least
+  // `workspace_size(size)` bytes, aligned to 8 bytes, which must
+  // outlive the object. Does not allocate.
+  LatinSquareCover(const int size, void* workspace);
+
+  LatinSquareCover(const LatinSquareCover&) = delete;
+  LatinSquareCover& operator=(const LatinSquareCover&) = delete;
+
+  int size() const { return size_; }
+
+  // Requires the cell to hold the value in every completion. Returns
+  // false, without changing anything, if this conflicts with the
+  // values fixed so far.
+  bool fix(const int row, const int column, const int value);
+
+  // Forgets all the fixed values.
+  void clear();
+
+  // Searches for a completion of the fixed values, and writes it to
+  // `cells` in row-major order. If a generator is given, the cell to
+  // branch on (among the most constrained ones) and the order of its
+  // values are random. Returns false if there is no completion. The
+  // fixed values stay in place.
+  bool solve(std::mt19937* generator, int* cells);
+
+ private:
+  struct Node {
+    int32_t left;
+    int32_t right;
+    int32_t up;
+    int32_t down;
+    // The header node of the node's column.
+    int32_t column;
+  };
+
+  // A branching point of the search: the column being covered, the
+  // row where the search started, and the row currently selected.
+  struct Level {
+    int32_t column;
+    int32_t first;
+    int32_t current;
+  };
+
+  void initialize(void* workspace);
+  void cover(const int column);
+  void uncover(const int column);
+  void select(const int node);
+  void unselect(const int node);
+  int choose_column(std::mt19937* generator) const;
+  // Returns the option (cell and value) a row node belongs to.
+  int option_of(const int node) const;
+
+  const int size_;
+  // The arena, unless the caller provided it.
+  std::vector<uint64_t> storage_;
+  // These arrays live in the arena. Node 0 is the root; nodes 1
+  // through 3 * size^2 are the column headers; then come three nodes
+  // per option.
+  Node* nodes_ = nullptr;
+  int32_t* column_size_ = nullptr;
+  Level* stack_ = nullptr;
+  // Row nodes selected by fix(), in order.
+  int32_t* fixed_ = nullptr;
+  int fixed_count_ = 0;
+};
+
+// Creates a random board with Dancing Links, into an existing board.
+// Returns false on failure.
+bool fill_dlx_board(Board& b, std::mt19937& generator);
+
+// Completes a board whose empty cells hold zero, choosing randomly
+// among the completions. Returns nothing if the board has no
+// completion.
+std::optional<Board> complete_board(const Board& partial, std::mt19937& generator);
+
+// Entry point for the --complete program mode. Returns a value
+// compatible with 'man 3 exit'.
+int run_completion(const ProgramOptions& options);
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "hint.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "puzzle.h"
+
+HintSession::HintSession(const int size, const int* clues) : size_(size) {
+  const size_t workspace_len = SolverState::workspace_size(size);
+  if (workspace_len == 0)
+    return;
+  workspace_.resize(workspace_len / sizeof(CandidateMask) + 1);
+  state_.emplace(size, clues, workspace_.data(), workspace_len);
+  if (!state_->ok() || !state_->initialize())
+    return;
+  placed_.assign(size * size, 0);
+  moves_.reserve(size * size);
+  ok_ = true;
+}
+
+bool HintSession::place(const int row, const int column, const int value) {
+  if (row < 0 || row >= size_ || column < 0 || column >= size_ || value < 1 || value > size_)
+    return false;
+  const int cell = row * size_ + column;
+  if (placed_[cell] != 0)
+    return false;
+
+  const size_t mark = state_->checkpoint();
+  if (!state_->assign(cell, value) || !state_->propagate()) {
+    state_->undo(mark);
+    return false;
+  }
+  placed_[cell] = value;
+  moves_.push_back(Move{mark, cell});
+  return true;
+}
+
+bool HintSession::undo() {
+  if (moves_.empty())
+    return false;
+  const Move& move = moves_.back();
+  state_->undo(move.mark);
+  placed_[move.cell] = 0;
+  moves_.pop_back();
+  return true;
+}
+
+int HintSession::placed(const int row, const int column) const {
+  return placed_[row * size_ + column];
+}
+
+std::optional<Hint> HintSession::next_hint() const {
+  // Deductions are reported in the order propagation made them, so
+  // that each one only depends on earlier ones.
+  int best = -1;
+  const int cells = size_ * size_;
+  for (int cell = 0; cell < cells; ++cell) {
+    if (placed_[cell] != 0 || state_->value(cell) == 0)
+      continue;
+    if (best < 0 || state_->step(cell) < state_->step(best))
+      best = cell;
+  }
+  if (best < 0)
+    return std::nullopt;
+  return Hint{best / size_, best % size_, state_->value(best), state_->rule(best)};
+}
+
+int run_hints(const ProgramOptions& options) {
+  const int size = options.board_size;
+  std::vector<int> clues;
+  if (!parse_clues(options.hint_options.clues, size, &clues)) {
+    std::cerr << "ERROR: expected " << 4 * size << " comma-separated clues between 0 and "
+              << size << ", got: " << options.hint_options.clues << std::endl;
+    return EXIT_FAILURE;
+  }
+  HintSession session{size, clues.data()};
+  if (!session.ok()) {
+    std::cerr << "ERROR: the clues are not consistent" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Follow the hints until they run out.
+  std::ofstream out{options.puzzle_output_file, std::ios::out};
+  int placed = 0;
+  while (const std::optional<Hint> hint = session.next_hint()) {
+    out << "Row " << hint->row + 1 << ", column " << hint->column + 1 << ": " << hint->value
+        << " (" << rule_name(hint->rule) << ")" << std::endl;
+    if (!session.place(hint->row, hint->column, hint->value)) {
+      std::cerr << "FATAL: a hint contradicts the clues. This should never happen." << std::endl;
+      return EXIT_FAILURE;
+    }
+    ++placed;
+  }
+  if (placed < size * size)
+    out << "No more cells are forced: " << size * size - placed << " left" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HINT_H
+#define HINT_H
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "options.h"
+#include "solve.h"
+
+// A cell that the clues and the placements so far force to a value.
+struct Hint {
+  int row;
+  int column;
+  int value;
+  DeductionRule rule;
+};
+
+// Keeps the candidates of a puzzle in play, for interactive hints.
+// Each placement only propagates through the rows and columns it
+// touches, and is undone by rolling back the solver trail to where it
+// started, without copying any state. After construction, placements,
+// undos and hints do not allocate.
+//
+// Undo is not constant time: it restores every candidate change the
+// placement caused, one trail entry each. That is at most what the
+// placement's own propagation did, and never more than size^3
+// entries, since each cell loses each candidate at most once.
+class HintSession {
+ public:
+  // Starts a session for a puzzle with 4 * size clues, laid out as in
+  // `Puzzle::clues()`.
+  HintSession(const int size, const int* clues);
+
+  HintSession(const HintSession&) = delete;
+  HintSession& operator=(const HintSession&) = delete;
+
+  // Returns whether the clues were acceptable and consistent. No other
+  // method may be called otherwise.
+  bool ok() const { return ok_; }
+
+  int size() const { return size_; }
+
+  // Places a value on an empty cell. Returns false, without changing
+  // anything, if the cell was already placed or the value contradicts
+  // the clues and the earlier placements.
+  bool place(const int row, const int column, const int value);
+
+  // Takes back the last placement, in time proportional to the
+  // candidate changes it caused. Returns false if there is none.
+  bool undo();
+
+  // Returns the value placed on a cell, or zero.
+  int placed(const int row, const int column) const;
+
+  // Returns the earliest deduction about a cell that has not been
+  // placed yet, or nothing if no cell is forced without guessing.
+  std::optional<Hint> next_hint() const;
+
+ private:
+  struct Move {
+    size_t mark;
+    int cell;
+  };
+
+  const int size_;
+  std::vector<CandidateMask> workspace_;
+  std::optional<SolverState> state_;
+  std::vector<uint8_t> placed_;
+  std::vector<Move> moves_;
+  bool ok_ = false;
+};
+
+// Entry point for the --hints program mode. Returns a value compatible
+// with 'man 3 exit'.
+int run_hints(const ProgramOptions& options);
+
+#endif
@@ -23,8 +23,19 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "bench.h"
+#include "clue_stats.h"
 #include "create.h"
+#include "dlx.h"
+#include "hint.h"
+#include "manifest.h"
 #include "options.h"
+#include "puzzle_file.h"
+#include "rating.h"
+#include "shard.h"
+#include "solution_store.h"
+#include "solve.h"
+#include "trace.h"
 
 bool parse_long(const char* nptr, long* result) {
   char* endptr = NULL;
@@ -34,6 +45,24 @@ bool parse_long(const char* nptr, long* result) {
           *nptr && !*endptr);
 }
 
+// Parses a list of up to three thread counts, separated by commas.
+bool parse_thread_counts(const char* nptr, PipelineOptions* result) {
+  int* counts[] = {&result->generator_threads, &result->clue_threads, &result->filter_threads};
+  for (int* count : counts) {
+    char* endptr = NULL;
+    const long value = strtol(nptr, &endptr, 10);
+    if (endptr == nptr || value <= 0 || value > 1024)
+      return false;
+    *count = value;
+    if (*endptr == '\0')
+      return true;
+    if (*endptr != ',')
+      return false;
+    nptr = endptr + 1;
+  }
+  return false;
+}
+
 ProgramOptions parse_options(int argc, char *argv[]) {
   ProgramOptions options;
 
@@ -43,12 +72,36 @@ ProgramOptions parse_options(int argc, char *argv[]) {
     {"seed",          required_argument, NULL, 's'},
     {"output-file",   required_argument, NULL, 'o'},
     {"solution-file", required_argument, NULL, 'f'},
+    {"count",         required_argument, NULL, 'n'},
+    {"unique",        no_argument,       NULL, 'u'},
+    {"portfolio",     no_argument,       NULL, 'P'},
+    {"difficulty",    required_argument, NULL, 'd'},
+    {"backend",       required_argument, NULL, 'k'},
+    {"checkpoint",    required_argument, NULL, 'K'},
+    {"resume",        no_argument,       NULL, 'R'},
+    {"threads",       required_argument, NULL, 'j'},
+    {"bench",         no_argument,       NULL, 'b'},
+    {"baseline",      required_argument, NULL, 'B'},
+    {"threshold",     required_argument, NULL, 'T'},
+    {"enumerate",     no_argument,       NULL, 'E'},
+    {"lookup",        required_argument, NULL, 'L'},
+    {"store",         required_argument, NULL, 'S'},
+    {"complete",      required_argument, NULL, 'C'},
+    {"solve-file",    required_argument, NULL, 'F'},
+    {"hints",         required_argument, NULL, 'H'},
+    {"manifest",      required_argument, NULL, 'M'},
+    {"shard",         required_argument, NULL, 'x'},
+    {"merge",         no_argument,       NULL, 'G'},
+    {"augment",       no_argument,       NULL, 'a'},
+    {"trace",         required_argument, NULL, 't'},
+    {"clue-stats",    required_argument, NULL, 'Q'},
+    {"cost-model",    required_argument, NULL, 'm'},
     {"help",          no_argument,       NULL, 'h'},
     {NULL, 0, NULL, 0}
   };
 
   while (true) {
-    const int opt = getopt_long(argc, argv, "c:z:s:o:f:h",
+    const int opt = getopt_long(argc, argv, "c:z:s:o:f:n:uPd:k:K:Rj:bB:T:EL:S:C:F:H:M:m:x:Gat:Q:h",
                                 long_options, NULL);
 
     if (opt == -1)
@@ -56,18 +109,19 @@ ProgramOptions parse_options(int argc, char *argv[]) {
       break;
 
     switch (opt) {
-    case 'c':
-      if (strcmp(optarg, "shuffle") == 0) {
-        options.mode = ProgramMode::CREATE;
-        options.create_options.mode = CreateMode::SHUFFLE;
-      } else if (strcmp(optarg, "random") == 0) {
-        options.mode = ProgramMode::CREATE;
-        options.create_options.mode = CreateMode::RANDOM;
+    case 'c': {
+      const std::optional<CreateMode> mode = parse_create_mode(optarg);
+      if (mode.has_value()) {
+        // With --complete, this picks the search instead.
+        if (options.mode != ProgramMode::COMPLETE)
+          options.mode = ProgramMode::CREATE;
+        options.create_options.mode = *mode;
       } else {
         std::cerr << "ERROR: Unrecognized puzzle creation mode: " << optarg << std::endl;
         options.mode = ProgramMode::PARSE_ERROR;
       }
       break;
+    }
     case 'z': {
       long size;
       if (!parse_long(optarg, &size)) {
@@ -100,6 +154,129 @@ ProgramOptions parse_options(int argc, char *argv[]) {
     case 'f':
       options.board_output_file = optarg;
       break;
+    case 'n': {
+      long count;
+      if (!parse_long(optarg, &count)) {
+        std::cerr << "ERROR: Cannot parse puzzle count: " << optarg << std::endl;
+        options.mode = ProgramMode::PARSE_ERROR;
+      } else if (count <= 0 || count > UINT32_MAX) {
+        std::cerr << "ERROR: Invalid puzzle count: " << count << std::endl;
+        options.mode = ProgramMode::PARSE_ERROR;
+      } else {
+        options.create_options.count = count;
+      }
+      break;
+    }
+    case 'u':
+      options.create_options.unique_only = true;
+      break;
+    case 'P':
+      options.create_options.portfolio = true;
+      break;
+    case 'd': {
+      const std::optional<DifficultyBand> band = parse_difficulty_band(optarg);
+      if (!band.has_value()) {
+        std::cerr << "ERROR: Unrecognized difficulty: " << optarg << std::endl;
+        options.mode = ProgramMode::PARSE_ERROR;
+      } else {
+        options.create_options.difficulty = *band;
+      }
+      break;
+    }
+    case 'k':
+      if (strcmp(optarg, "search") == 0) {
+        options.solver_backend = SolverBackend::SEARCH;
+      } else if (strcmp(optarg, "cdcl") == 0) {
+        options.solver_backend = SolverBackend::CDCL;
+      } else {
+        std::cerr << "ERROR: Unrecognized solver backend: " << optarg << std::endl;
+        options.mode = ProgramMode::PARSE_ERROR;
+      }
+      break;
+    case 'K':
+      options.create_options.checkpoint_file = optarg;
+      break;
+    case 'R':
+      options.create_options.resume = true;
+      break;
+    case 'j':
+      if (!parse_thread_counts(optarg, &options.create_options.pipeline)) {
+        std::cerr << "ERROR: Cannot parse thread counts: " << optarg << std::endl;
+        options.mode = ProgramMode::PARSE_ERROR;
+      }
+      break;
+    case 'b':
+      options.mode = ProgramMode::BENCH;
+      break;
+    case 'B':
+      options.bench_options.baseline_file = optarg;
+      break;
+    case 'T': {
+      char* endptr = NULL;
+      const double threshold = strtod(optarg, &endptr);
+      if (!*optarg || *endptr || threshold < 0) {
+        std::cerr << "ERROR: Invalid regression threshold: " << optarg << std::endl;
+        options.mode = ProgramMode::PARSE_ERROR;
+      } else {
+        options.bench_options.threshold_percent = threshold;
+      }
+      break;
+    }
+    case 'E':
+      options.mode = ProgramMode::ENUMERATE;
+      break;
+    case 'L':
+      options.mode = ProgramMode::LOOKUP;
+      options.store_options.clues = optarg;
+      break;
+    case 'S':
+      options.store_options.store_file = optarg;
+      break;
+    case 'C':
+      options.mode = ProgramMode::COMPLETE;
+      options.complete_options.board_file = optarg;
+      break;
+    case 'F':
+      options.mode = ProgramMode::SOLVE_FILE;
+      options.batch_options.puzzle_file = optarg;
+      break;
+    case 'H':
+      options.mode = ProgramMode::HINTS;
+      options.hint_options.clues = optarg;
+      break;
+    case 'M':
+      options.mode = ProgramMode::MANIFEST;
+      options.manifest_options.manifest_file = optarg;
+      break;
+    case 'm':
+      options.manifest_options.cost_file = optarg;
+      break;
+    case 'x':
+      if (!parse_shard(optarg, &options.create_options.shard_index,
+                       &options.create_options.shard_count)) {
+        std::cerr << "ERROR: Invalid shard (expected INDEX/COUNT): " << optarg << std::endl;
+        options.mode = ProgramMode::PARSE_ERROR;
+      }
+      break;
+    case 'G':
+      options.mode = ProgramMode::MERGE;
+      break;
+    case 'a':
+      options.create_options.augment = true;
+      break;
+    case 't':
+      options.trace_file = optarg;
+      break;
+    case 'Q': {
+      // Either a creation mode, or a file of puzzles.
+      options.mode = ProgramMode::CLUE_STATS;
+      const std::optional<CreateMode> mode = parse_create_mode(optarg);
+      if (mode.has_value())
+        options.create_options.mode = *mode;
+      else
+        options.stats_options.puzzle_file = optarg;
+      break;
+    }
     case 'h':
       options.mode = ProgramMode::HELP;
       break;
@@ -119,6 +296,12 @@ ProgramOptions parse_options(int argc, char *argv[]) {
       break;
   }
 
+  if (options.mode == ProgramMode::MERGE) {
+    // The remaining parameters are the files to merge.
+    options.merge_options.inputs = argv + optind;
+    options.merge_options.input_count = argc - optind;
+    optind = argc;
+  }
   if (options.mode != ProgramMode::PARSE_ERROR && options.mode != ProgramMode::HELP && optind < argc) {
     std::cerr << "ERROR: Unrecognized parameters on the commandline:";
     while (optind < argc)
@@ -137,13 +320,82 @@ ProgramOptions parse_options(int argc, char *argv[]) {
     std::cerr << "Usage: " << argv[0]
               << " (-c|--create) MODE [-z|--size SIZE] [-s|--seed SEED]"
               << " [-o|--output-file OUTPUT_FILE] [-f|--solution-file SOLUTION_FILE]"
+              << " [-n|--count COUNT] [-u|--unique] [-P|--portfolio]"
+              << " [-d|--difficulty DIFFICULTY] [-k|--backend BACKEND] [-j|--threads THREADS]"
+              << " [-K|--checkpoint CHECKPOINT_FILE [-R|--resume]] [-x|--shard SHARD] [-a|--augment]"
+              << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-b|--bench) [-B|--baseline BASELINE_FILE] [-T|--threshold PERCENT]"
+              << " [-o|--output-file OUTPUT_FILE]" << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-E|--enumerate) [-z|--size SIZE] (-S|--store STORE_FILE) [-j|--threads THREADS]"
               << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-L|--lookup) CLUES [-z|--size SIZE] [-S|--store STORE_FILE] [-P|--portfolio]"
+              << " [-k|--backend BACKEND] [-o|--output-file OUTPUT_FILE]" << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-C|--complete) BOARD_FILE [-c|--create MODE] [-s|--seed SEED] [-o|--output-file OUTPUT_FILE]"
+              << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-F|--solve-file) PUZZLE_FILE [-k|--backend BACKEND] [-j|--threads THREADS]"
+              << " [-o|--output-file OUTPUT_FILE]" << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-H|--hints) CLUES [-z|--size SIZE] [-o|--output-file OUTPUT_FILE]" << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-M|--manifest) MANIFEST_FILE [-m|--cost-model COST_FILE] [-j|--threads THREADS]"
+              << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-G|--merge) [-o|--output-file OUTPUT_FILE] RECORD_FILE..." << std::endl;
+    std::cerr << "       " << argv[0]
+              << " (-Q|--clue-stats) SOURCE [-z|--size SIZE] [-s|--seed SEED] [-n|--count COUNT]"
+              << " [-j|--threads THREADS] [-o|--output-file OUTPUT_FILE]" << std::endl;
+    std::cerr << "All modes also accept [-t|--trace TRACE_FILE]." << std::endl;
     std::cerr << "Where:" << std::endl
-              << "  MODE is the puzzle creation mode ('shuffle' or 'random')" << std::endl
+              << "  MODE is the puzzle creation mode ('shuffle', 'random' or 'dlx')" << std::endl
               << "  SIZE is the board size (default: 5)" << std::endl
               << "  SEED is the seed to use for puzzle creation (default: a random seed is used)" << std::endl
               << "  OUTPUT_FILE is the file where the puzzle should be printed (default: stdout)" << std::endl
-              << "  SOLUTION_FILE is the file where the solution should be printed (default: not printed)" << std::endl;
+              << "  SOLUTION_FILE is the file where the solution should be printed (default: not printed)" << std::endl
+              << "  COUNT is the number of puzzles to create (default: 1)" << std::endl
+              << "  --unique keeps only the puzzles that have a unique solution" << std::endl
+              << "  --portfolio solves by racing several solver strategies, and prints how often" << std::endl
+              << "    each one won" << std::endl
+              << "  DIFFICULTY keeps only the unique puzzles of a difficulty ('easy', 'medium'," << std::endl
+              << "    'hard' or 'expert'), or of a range of them such as 'easy-medium'" << std::endl
+              << "  BACKEND is the solver used without --portfolio ('search' or 'cdcl'; default:" << std::endl
+              << "    'search' up to size " << MAX_SEARCH_BACKEND_SIZE
+              << ", 'cdcl' above); 'cdcl' is much faster on large puzzles" << std::endl
+              << "  THREADS is the number of threads generating boards, computing clues and" << std::endl
+              << "    checking uniqueness, separated by commas (default: based on the cores)" << std::endl
+              << "  CHECKPOINT_FILE is where the 'random' creation of a single board saves its" << std::endl
+              << "    progress; --resume continues from it, with the same result" << std::endl
+              << "  SHARD is INDEX/COUNT: creates the boards of one of COUNT disjoint ranges of" << std::endl
+              << "    64-bit seeds, and prints them as records of seed, mode, size, clues and" << std::endl
+              << "    solution; SEED defaults to 0" << std::endl
+              << "  --augment also prints the distinct rotations and reflections of each board" << std::endl
+              << "    and puzzle, counting each one towards COUNT" << std::endl
+              << "  --bench runs a fixed set of creation workloads and prints their performance as JSON" << std::endl
+              << "  BASELINE_FILE is the output of a previous --bench run to compare against" << std::endl
+              << "  PERCENT is the slowdown that counts as a regression (default: 10)" << std::endl
+              << "  --enumerate writes the clues and solutions of every board of SIZE (at most "
+              << MAX_STORE_SIZE << ") to STORE_FILE" << std::endl
+              << "  CLUES are the 4*SIZE clues (top, bottom, left, right; 0 if missing) to solve," << std::endl
+              << "    separated by commas; full sets of clues are answered from STORE_FILE, and" << std::endl
+              << "    --hints prints the cells they force, one deduction at a time" << std::endl
+              << "  BOARD_FILE is a partially filled board to complete, in the format printed to" << std::endl
+              << "    SOLUTION_FILE, with 0 in the empty cells; MODE picks the search ('random' or" << std::endl
+              << "    'dlx', the default)" << std::endl
+              << "  PUZZLE_FILE holds puzzles to solve, in the format printed to OUTPUT_FILE;" << std::endl
+              << "    --solve-file counts how many have a unique solution" << std::endl
+              << "  MANIFEST_FILE lists creation jobs, one per line, as 'MODE SIZE FIRST_SEED COUNT" << std::endl
+              << "    OUTPUT_FILE [SOLUTION_FILE]'; they run on THREADS threads, costliest first" << std::endl
+              << "  COST_FILE keeps the time each mode and size takes, learned across runs" << std::endl
+              << "  --merge combines the records of several shards, sorted by seed and without" << std::endl
+              << "    duplicates" << std::endl
+              << "  SOURCE is a MODE, to create COUNT boards of SIZE, or a PUZZLE_FILE;" << std::endl
+              << "    --clue-stats prints the distribution of their clues as JSON" << std::endl
+              << "  TRACE_FILE is where a timeline of the phases of the run is written, as Chrome" << std::endl
+              << "    trace-event JSON" << std::endl;
   }
 
   return options;
@@ -151,6 +403,10 @@ ProgramOptions parse_options(int argc, char *argv[]) {
 
 int main(int argc, char *argv[]) {
   const ProgramOptions options = parse_options(argc, argv);
+  // Only explicit modes do any work worth tracing.
+  if (options.mode > ProgramMode::HELP && options.trace_file != nullptr &&
+      !start_trace(options.trace_file))
+    exit(EXIT_FAILURE);
 
   switch (options.mode) {
   case ProgramMode::UNSPECIFIED:
@@ -160,5 +416,23 @@ int main(int argc, char *argv[]) {
     exit(EXIT_SUCCESS);
   case ProgramMode::CREATE:
     exit(create_board(options));
+  case ProgramMode::BENCH:
+    exit(run_benchmark(options));
+  case ProgramMode::ENUMERATE:
+    exit(run_enumeration(options));
+  case ProgramMode::LOOKUP:
+    exit(run_lookup(options));
+  case ProgramMode::COMPLETE:
+    exit(run_completion(options));
+  case ProgramMode::SOLVE_FILE:
+    exit(run_batch_solve(options));
+  case ProgramMode::HINTS:
+    exit(run_hints(options));
+  case ProgramMode::MANIFEST:
+    exit(run_manifest(options));
+  case ProgramMode::MERGE:
+    exit(run_merge(options));
+  case ProgramMode::CLUE_STATS:
+    exit(run_clue_stats(options));
   }
 }
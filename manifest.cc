@@ -0,0 +1,426 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "manifest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <time.h>
+
+#include "board.h"
+#include "create.h"
+#include "options.h"
+#include "puzzle.h"
+
+namespace {
+
+// Each job is split in tasks, so that there are about this many tasks
+// per thread. Smaller tasks balance better, but cost more overhead.
+constexpr double TASKS_PER_THREAD = 32;
+// The most boards a task may hold in memory before writing them out.
+constexpr uint32_t MAX_TASK_BOARDS = 4096;
+// How many tasks per thread of one job may be started before the
+// earliest of them is written. Later tasks wait, so that a slow task
+// does not leave the output of all the others of its job in memory.
+constexpr int CHUNKS_AHEAD_PER_THREAD = 4;
+// How much a new timing weighs against the saved estimate.
+constexpr double COST_LEARNING_RATE = 0.5;
+
+// The estimate for a mode and size that were never timed before.
+double default_estimate(const CreateMode mode, const int size) {
+  switch (mode) {
+  case CreateMode::SHUFFLE:
+    // A fixed number of swaps, each linear in the size.
+    return 1e-3 * (1 + size / 16.0);
+  case CreateMode::DLX:
+    return 1e-7 * std::pow(size, 3);
+  case CreateMode::RANDOM:
+    // The backtracking grows exponentially past small sizes.
+    return 1e-7 * std::pow(size, 4) * std::pow(1.2, std::max(0, size - 8));
+  case CreateMode::UNSPECIFIED:
+    break;
+  }
+  return 1;
+}
+
+// Returns the CPU time used by the calling thread, which unlike the
+// wall time does not depend on how many threads share the cores.
+double thread_seconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// A contiguous range of the boards of a job. The queues only hold the
+// job and the cost: the range is assigned when the task is started,
+// so that the tasks of a job start in order.
+struct Task {
+  int job;
+  double cost;
+  // Index of the task within its job, which orders the output.
+  int chunk = 0;
+  uint32_t first = 0;
+  uint32_t count = 0;
+};
+
+// The progress and output of a job. Tasks may finish in any order;
+// their output is held until all the earlier ones of the same job are
+// written.
+struct JobOutput {
+  std::mutex mutex;
+  std::condition_variable written;
+  std::ofstream puzzles;
+  std::ofstream solutions;
+  std::vector<std::unique_ptr<std::pair<std::string, std::string>>> pending;
+  uint32_t boards_per_task = 0;
+  // The next task to start, and the next one to write.
+  int next_start = 0;
+  int next_chunk = 0;
+  // Whether writing failed, after reporting why.
+  bool failed = false;
+};
+
+// A thread's own tasks. The owner and the thieves both take the most
+// expensive task first, from the back.
+struct WorkerQueue {
+  std::mutex mutex;
+  std::deque<Task> tasks;
+};
+
+std::optional<Task> take(WorkerQueue& queue) {
+  std::lock_guard<std::mutex> lock{queue.mutex};
+  if (queue.tasks.empty())
+    return std::nullopt;
+  Task task = queue.tasks.back();
+  queue.tasks.pop_back();
+  return task;
+}
+
+// Assigns the next range of boards of its job to `task`, waiting while
+// too many tasks of the job are ahead of its output. Returns false if
+// the run failed meanwhile.
+bool start_task(const ManifestJob& job, JobOutput& output, const int limit,
+                const std::atomic<bool>& failed, Task& task) {
+  std::unique_lock<std::mutex> lock{output.mutex};
+  output.written.wait(lock, [&] {
+    return failed.load() || output.next_start - output.next_chunk < limit;
+  });
+  if (failed.load())
+    return false;
+  task.chunk = output.next_start++;
+  task.first = task.chunk * output.boards_per_task;
+  task.count = std::min(output.boards_per_task, job.count - task.first);
+  return true;
+}
+
+// Creates the boards of a task, and returns their puzzles as printed,
+// each preceded by an empty line unless it is the first of its job.
+// The boards are returned the same way, unless the job has no
+// solution file.
+bool run_task(const ManifestJob& job, const Task& task, std::string* solutions,
+              std::string* puzzles) {
+  std::ostringstream board_out;
+  std::ostringstream puzzle_out;
+  for (uint32_t i = task.first; i < task.first + task.count; ++i) {
+    std::mt19937 generator{job.first_seed + i};
+    const std::optional<Board> b = run_creation_algorithm(job.mode, job.size, generator);
+    if (!b.has_value()) {
+      std::cerr << "ERROR: something went wrong while creating the board with seed "
+                << job.first_seed + i << std::endl;
+      return false;
+    }
+    if (i > 0) {
+      board_out << std::endl;
+      puzzle_out << std::endl;
+    }
+    if (!job.solution_file.empty())
+      b->print(board_out);
+    Puzzle{*b}.print(puzzle_out);
+  }
+  *solutions = board_out.str();
+  *puzzles = puzzle_out.str();
+  return true;
+}
+
+// Queues the output of a task, and writes out whatever is now in
+// order. Files are only opened while they are being written, so that
+// a manifest may list more jobs than there are file descriptors.
+bool write_output(const ManifestJob& job, JobOutput& output, const int chunks, const Task& task,
+                  std::string solutions, std::string puzzles) {
+  std::lock_guard<std::mutex> lock{output.mutex};
+  if (output.failed)
+    return false;
+  auto fail = [&output](const char* what, const std::string& path) {
+    std::cerr << "ERROR: cannot " << what << ": " << path << std::endl;
+    output.failed = true;
+    return false;
+  };
+  output.pending[task.chunk] =
+    std::make_unique<std::pair<std::string, std::string>>(std::move(solutions), std::move(puzzles));
+  const int before = output.next_chunk;
+  bool ok = true;
+  while (ok && output.next_chunk < chunks && output.pending[output.next_chunk] != nullptr) {
+    if (output.next_chunk == 0) {
+      output.puzzles.open(job.output_file, std::ios::out | std::ios::trunc);
+      if (!output.puzzles.is_open())
+        return fail("open output file", job.output_file);
+      if (!job.solution_file.empty()) {
+        output.solutions.open(job.solution_file, std::ios::out | std::ios::trunc);
+        if (!output.solutions.is_open())
+          return fail("open solution file", job.solution_file);
+      }
+    }
+    const std::pair<std::string, std::string>& text = *output.pending[output.next_chunk];
+    if (!job.solution_file.empty())
+      output.solutions << text.first;
+    output.puzzles << text.second;
+    output.pending[output.next_chunk++].reset();
+    ok = output.puzzles.good() && output.solutions.good();
+  }
+  if (output.next_chunk == chunks) {
+    output.puzzles.close();
+    if (!job.solution_file.empty())
+      output.solutions.close();
+  }
+  if (output.puzzles.fail())
+    return fail("write output file", job.output_file);
+  if (output.solutions.fail())
+    return fail("write solution file", job.solution_file);
+  if (output.next_chunk != before)
+    output.written.notify_all();
+  return true;
+}
+
+}  // namespace
+
+std::optional<std::vector<ManifestJob>> parse_manifest(std::istream& istream) {
+  std::vector<ManifestJob> jobs;
+  std::string line;
+  for (int number = 1; std::getline(istream, line); ++number) {
+    std::istringstream fields{line};
+    std::string mode;
+    if (!(fields >> mode) || mode[0] == '#')
+      continue;
+
+    ManifestJob job;
+    const std::optional<CreateMode> create_mode = parse_create_mode(mode.c_str());
+    long size = 0;
+    long first_seed = 0;
+    long count = 0;
+    std::string extra;
+    if (!create_mode.has_value() || !(fields >> size >> first_seed >> count >> job.output_file) ||
+        size <= 1 || size > UINT16_MAX || first_seed <= 0 || count <= 0 ||
+        first_seed + count - 1 > UINT32_MAX || (fields >> job.solution_file && fields >> extra)) {
+      std::cerr << "ERROR: malformed job on line " << number
+                << " (expected MODE SIZE FIRST_SEED COUNT OUTPUT_FILE [SOLUTION_FILE]): " << line
+                << std::endl;
+      return std::nullopt;
+    }
+    job.mode = *create_mode;
+    job.size = size;
+    job.first_seed = first_seed;
+    job.count = count;
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+bool CostModel::load(const char* path) {
+  std::ifstream in{path};
+  if (!in)
+    return true;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields{line};
+    std::string mode;
+    int size;
+    double seconds;
+    if (!(fields >> mode))
+      continue;
+    const std::optional<CreateMode> create_mode = parse_create_mode(mode.c_str());
+    if (!create_mode.has_value() || !(fields >> size >> seconds) || seconds < 0) {
+      std::cerr << "ERROR: malformed cost model line: " << line << std::endl;
+      return false;
+    }
+    entries_[{*create_mode, size}] = Entry{seconds};
+  }
+  return true;
+}
+
+bool CostModel::save(const char* path) const {
+  const std::string temporary = std::string(path) + ".tmp";
+  {
+    std::ofstream out{temporary, std::ios::out | std::ios::trunc};
+    for (const auto& [key, entry] : entries_) {
+      double seconds = entry.seconds_per_board;
+      if (entry.boards > 0) {
+        const double observed = entry.seconds / entry.boards;
+        seconds = std::isnan(seconds) ? observed :
+          (1 - COST_LEARNING_RATE) * seconds + COST_LEARNING_RATE * observed;
+      }
+      if (!std::isnan(seconds))
+        out << create_mode_name(key.first) << " " << key.second << " " << seconds << std::endl;
+    }
+    if (!out) {
+      std::cerr << "ERROR: cannot write cost model: " << temporary << std::endl;
+      return false;
+    }
+  }
+  if (std::rename(temporary.c_str(), path) != 0) {
+    std::cerr << "ERROR: cannot replace cost model: " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+double CostModel::estimate(const CreateMode mode, const int size) const {
+  const auto i = entries_.find({mode, size});
+  if (i == entries_.end() || std::isnan(i->second.seconds_per_board))
+    return default_estimate(mode, size);
+  return i->second.seconds_per_board;
+}
+
+void CostModel::record(const CreateMode mode, const int size, const uint32_t boards,
+                       const double seconds) {
+  // Entries first seen in this run have no saved estimate.
+  Entry& entry = entries_.try_emplace({mode, size}, Entry{NAN}).first->second;
+  entry.seconds += seconds;
+  entry.boards += boards;
+}
+
+bool run_jobs(const std::vector<ManifestJob>& jobs, const int threads, CostModel& costs) {
+  // Split the jobs in tasks of roughly equal cost, except that a task
+  // holds at least one board.
+  double total_cost = 0;
+  for (const ManifestJob& job : jobs)
+    total_cost += job.count * costs.estimate(job.mode, job.size);
+  const double task_cost = total_cost / (threads * TASKS_PER_THREAD);
+
+  std::vector<Task> tasks;
+  std::vector<int> chunks(jobs.size(), 0);
+  std::vector<JobOutput> outputs(jobs.size());
+  for (size_t j = 0; j < jobs.size(); ++j) {
+    const ManifestJob& job = jobs[j];
+    const double board_cost = costs.estimate(job.mode, job.size);
+    const uint32_t boards_per_task = std::clamp<double>(
+      std::floor(task_cost / board_cost), 1, MAX_TASK_BOARDS);
+    for (uint32_t first = 0; first < job.count; first += boards_per_task) {
+      const uint32_t count = std::min(boards_per_task, job.count - first);
+      tasks.push_back(Task{int(j), count * board_cost});
+      ++chunks[j];
+    }
+    outputs[j].boards_per_task = boards_per_task;
+    outputs[j].pending.resize(chunks[j]);
+  }
+
+  // Deal the tasks from the most expensive down, so that each queue is
+  // sorted with its most expensive task at the back. The sort is stable
+  // so that the tasks of a job stay together, in order.
+  std::stable_sort(tasks.begin(), tasks.end(),
+                   [](const Task& a, const Task& b) { return a.cost > b.cost; });
+  std::vector<WorkerQueue> queues(threads);
+  for (size_t i = 0; i < tasks.size(); ++i)
+    queues[i % threads].tasks.push_front(tasks[i]);
+
+  std::mutex costs_mutex;
+  std::atomic<bool> failed{false};
+  const int limit = CHUNKS_AHEAD_PER_THREAD * threads;
+  // Wakes up the threads waiting to start a task, so that they notice.
+  auto fail = [&] {
+    failed.store(true);
+    for (JobOutput& output : outputs) {
+      std::lock_guard<std::mutex> lock{output.mutex};
+      output.written.notify_all();
+    }
+  };
+
+  auto work = [&](const int self) {
+    while (!failed.load(std::memory_order_relaxed)) {
+      // Take from our own queue, or steal from the others.
+      std::optional<Task> task;
+      for (int i = 0; i < threads && !task.has_value(); ++i)
+        task = take(queues[(self + i) % threads]);
+      if (!task.has_value())
+        return;
+
+      const ManifestJob& job = jobs[task->job];
+      if (!start_task(job, outputs[task->job], limit, failed, *task))
+        return;
+      const double start = thread_seconds();
+      std::string solutions;
+      std::string puzzles;
+      if (!run_task(job, *task, &solutions, &puzzles)) {
+        fail();
+        return;
+      }
+      const double elapsed = thread_seconds() - start;
+      {
+        std::lock_guard<std::mutex> lock{costs_mutex};
+        costs.record(job.mode, job.size, task->count, elapsed);
+      }
+      if (!write_output(job, outputs[task->job], chunks[task->job], *task, std::move(solutions),
+                        std::move(puzzles))) {
+        fail();
+        return;
+      }
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; ++i)
+    pool.emplace_back(work, i);
+  work(0);
+  for (std::thread& t : pool)
+    t.join();
+  return !failed.load();
+}
+
+int run_manifest(const ProgramOptions& options) {
+  const ManifestOptions& manifest_options = options.manifest_options;
+  std::ifstream in{manifest_options.manifest_file};
+  if (!in) {
+    std::cerr << "ERROR: cannot read manifest file: " << manifest_options.manifest_file
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::optional<std::vector<ManifestJob>> jobs = parse_manifest(in);
+  if (!jobs.has_value())
+    return EXIT_FAILURE;
+
+  CostModel costs;
+  if (manifest_options.cost_file != nullptr && !costs.load(manifest_options.cost_file))
+    return EXIT_FAILURE;
+
+  const int threads = resolve_thread_count(options.create_options.pipeline.generator_threads);
+  if (!run_jobs(*jobs, threads, costs))
+    return EXIT_FAILURE;
+
+  if (manifest_options.cost_file != nullptr && !costs.save(manifest_options.cost_file))
+    return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+}
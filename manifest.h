@@ -0,0 +1,89 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "options.h"
+
+// A line of a manifest: `count` puzzles of the given mode and size,
+// created with seeds `first_seed` through `first_seed + count - 1`
+// and written, in seed order, to `output_file`. Their solutions go to
+// `solution_file`, if not empty.
+struct ManifestJob {
+  CreateMode mode;
+  uint16_t size;
+  uint32_t first_seed;
+  uint32_t count;
+  std::string output_file;
+  std::string solution_file;
+};
+
+// Reads a manifest, one job per line, as
+//   MODE SIZE FIRST_SEED COUNT OUTPUT_FILE [SOLUTION_FILE]
+// Empty lines and lines starting with '#' are skipped. Returns nothing,
+// after reporting the line, if a job is malformed.
+std::optional<std::vector<ManifestJob>> parse_manifest(std::istream& istream);
+
+// Estimates how long creating one board takes, for each mode and size.
+// Estimates start from a fixed guess, and are refined by the timings
+// of earlier runs.
+class CostModel {
+ public:
+  // Loads the estimates saved by save(). A missing file is not an
+  // error; a malformed one is.
+  bool load(const char* path);
+
+  // Saves the estimates, replacing the file atomically.
+  bool save(const char* path) const;
+
+  // Returns the estimated seconds per board.
+  double estimate(const CreateMode mode, const int size) const;
+
+  // Records that `boards` boards took `seconds` in total.
+  void record(const CreateMode mode, const int size, const uint32_t boards,
+              const double seconds);
+
+ private:
+  struct Entry {
+    double seconds_per_board;
+    // Timings recorded in this run.
+    double seconds = 0;
+    uint64_t boards = 0;
+  };
+  std::map<std::pair<CreateMode, int>, Entry> entries_;
+};
+
+// Runs the jobs on a pool of `threads` work-stealing threads, starting
+// from the most expensive work according to `costs`, which is updated
+// with the timings of this run. Returns false on failure.
+bool run_jobs(const std::vector<ManifestJob>& jobs, const int threads, CostModel& costs);
+
+// Entry point for the --manifest program mode. Returns a value
+// compatible with 'man 3 exit'.
+int run_manifest(const ProgramOptions& options);
+
+#endif
@@ -19,7 +19,9 @@
 #ifndef OPTIONS_H
 #define OPTIONS_H
 
+#include <algorithm>
 #include <cstdint>
+#include <thread>
 
 enum class ProgramMode {
   UNSPECIFIED = 0,
@@ -29,6 +31,15 @@ enum class ProgramMode {
   // Explicit modes (the argument parser selects them by reading the
   // commandline)
   CREATE,
+  BENCH,
+  ENUMERATE,
+  LOOKUP,
+  COMPLETE,
+  SOLVE_FILE,
+  HINTS,
+  MANIFEST,
+  MERGE,
+  CLUE_STATS,
 };
 
 enum class CreateMode {
@@ -37,12 +48,131 @@ enum class CreateMode {
   SHUFFLE,
   // Generates a fully random board, from the empty state
   RANDOM,
+  // Solves an exact cover problem with Dancing Links, from the empty
+  // state
+  DLX,
 };
 
+// Defines which algorithm solves puzzles.
+enum class SolverBackend {
+  // Backtracking search over candidate bitmasks, with propagation.
+  SEARCH = 0,
+  // Conflict-driven clause learning over a SAT encoding. Scales
+  // better to large puzzles with few clues.
+  CDCL,
+  // SEARCH for small puzzles, CDCL for the larger ones it can handle.
+  AUTO,
+};
+
+// Difficulty levels, from the rules a logic-only solver needs.
+enum class Difficulty {
+  UNSPECIFIED = 0,
+  // Singles and the bounds implied by the distance from each clue.
+  EASY,
+  // Also counting the buildings already visible from a clue.
+  MEDIUM,
+  // Also enumerating the arrangements of whole lines.
+  HARD,
+  // Guessing is required.
+  EXPERT,
+};
+
+// An inclusive range of difficulties.
+struct DifficultyBand {
+  Difficulty min = Difficulty::UNSPECIFIED;
+  Difficulty max = Difficulty::UNSPECIFIED;
+};
+
+// Number of threads for each stage of bulk creation. Zero means
+// that a default is picked based on the available cores.
+struct PipelineOptions {
+  int generator_threads = 0;
+  int clue_threads = 0;
+  int filter_threads = 0;
+};
+
+// Returns `requested` if it is positive, or else the number of
+// hardware threads, and at least one.
+inline int resolve_thread_count(const int requested) {
+  return requested > 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+}
+
 struct CreateOptions {
   CreateMode mode = CreateMode::UNSPECIFIED;
-  // If unspecified, 'man 2 time' is used.
+  // If unspecified, 'man 2 time' is used, except for shards, which
+  // use 0. When creating more than one board, the n-th board uses
+  // 'seed + n'.
   uint32_t seed = 0;
+  // How many puzzles to create.
+  uint32_t count = 1;
+  // Whether to keep only the puzzles that have a unique solution.
+  bool unique_only = false;
+  // Whether to check uniqueness by racing several solver strategies.
+  bool portfolio = false;
+  // If specified, keeps only the puzzles that have a unique solution
+  // and a difficulty in this band.
+  DifficultyBand difficulty;
+  // If not null, random creation of a single board saves its progress
+  // to this file, and continues from it if 'resume' is set.
+  const char* checkpoint_file = nullptr;
+  bool resume = false;
+  // If 'shard_count' is not zero, bulk creation covers shard
+  // 'shard_index' of the seed space, and writes records with seeds.
+  uint32_t shard_index = 0;
+  uint32_t shard_count = 0;
+  // Whether bulk creation also prints the rotations and reflections
+  // of each board, as distinct puzzles.
+  bool augment = false;
+  PipelineOptions pipeline;
+};
+
+struct BenchOptions {
+  // A previous benchmark output to compare against, if any.
+  const char* baseline_file = nullptr;
+  // Slowdown, in percent, above which a workload counts as a regression.
+  double threshold_percent = 10;
+};
+
+struct StoreOptions {
+  // The solution store to write (--enumerate) or read (--lookup).
+  const char* store_file = nullptr;
+  // The clues to look up, as a comma-separated list.
+  const char* clues = nullptr;
+};
+
+struct CompleteOptions {
+  // The partially filled board to complete.
+  const char* board_file = nullptr;
+};
+
+struct BatchOptions {
+  // The puzzles to solve, as written by bulk creation.
+  const char* puzzle_file = nullptr;
+};
+
+struct HintOptions {
+  // The clues to follow hints for, as a comma-separated list.
+  const char* clues = nullptr;
+};
+
+struct ManifestOptions {
+  // The jobs to run.
+  const char* manifest_file = nullptr;
+  // Where the estimated cost of each job is learned across runs, if
+  // anywhere.
+  const char* cost_file = nullptr;
+};
+
+struct MergeOptions {
+  // The record files to merge.
+  const char* const* inputs = nullptr;
+  int input_count = 0;
+};
+
+struct StatsOptions {
+  // The puzzles to read. If null, boards are created instead, as with
+  // --create.
+  const char* puzzle_file = nullptr;
 };
 
 struct ProgramOptions {
@@ -50,8 +180,28 @@ struct ProgramOptions {
   uint16_t board_size = 5;
   const char* puzzle_output_file = "/dev/stdout";
   const char* board_output_file = "/dev/null";
+  // Used wherever puzzles are solved or checked for uniqueness.
+  SolverBackend solver_backend = SolverBackend::AUTO;
+  // If not null, a timeline of the phases of the run is written here.
+  const char* trace_file = nullptr;
   // Valid only if 'mode == ProgramMode::CREATE'
   CreateOptions create_options;
+  // Valid only if 'mode == ProgramMode::BENCH'
+  BenchOptions bench_options;
+  // Valid only if 'mode' is ProgramMode::ENUMERATE or ProgramMode::LOOKUP
+  StoreOptions store_options;
+  // Valid only if 'mode == ProgramMode::COMPLETE'
+  CompleteOptions complete_options;
+  // Valid only if 'mode == ProgramMode::SOLVE_FILE'
+  BatchOptions batch_options;
+  // Valid only if 'mode == ProgramMode::HINTS'
+  HintOptions hint_options;
+  // Valid only if 'mode == ProgramMode::MANIFEST'
+  ManifestOptions manifest_options;
+  // Valid only if 'mode == ProgramMode::MERGE'
+  MergeOptions merge_options;
+  // Valid only if 'mode == ProgramMode::CLUE_STATS'
+  StatsOptions stats_options;
 };
 
 #endif
@@ -0,0 +1,326 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "portfolio.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "alloc_stats.h"
+#include "cdcl.h"
+#include "trace.h"
+
+std::vector<PortfolioStrategy> default_portfolio() {
+  std::vector<PortfolioStrategy> strategies(6);
+  strategies[0].name = "min-candidates/ascending";
+  strategies[1].name = "min-candidates/descending";
+  strategies[1].options.value_order = ValueOrder::DESCENDING;
+  strategies[2].name = "min-candidates/random-1";
+  strategies[2].options.value_order = ValueOrder::RANDOM;
+  strategies[2].options.seed = 1;
+  strategies[3].name = "min-candidates/random-2";
+  strategies[3].options.value_order = ValueOrder::RANDOM;
+  strategies[3].options.seed = 2;
+  strategies[4].name = "row-major/ascending";
+  strategies[4].options.variable_order = VariableOrder::ROW_MAJOR;
+  strategies[5].name = "cdcl";
+  strategies[5].options.backend = SolverBackend::CDCL;
+  return strategies;
+}
+
+void PortfolioStats::record(const bool solo, const int winner) {
+  if (solo)
+    solo_.fetch_add(1, std::memory_order_relaxed);
+  else
+    races_.fetch_add(1, std::memory_order_relaxed);
+  wins_[winner].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PortfolioStats::print(std::ostream& ostream, const PortfolioOptions& options) const {
+  const long solo = solo_.load();
+  const long races = races_.load();
+  ostream << "Portfolio: " << solo + races << " puzzles, " << solo
+          << " answered before racing, " << races << " raced" << std::endl;
+  for (size_t i = 0; i < options.strategies.size() && i < MAX_PORTFOLIO_STRATEGIES; ++i) {
+    long wins = wins_[i].load();
+    if (i == 0)
+      // Solo answers are not race wins.
+      wins -= solo;
+    ostream << "  " << options.strategies[i].name << ": " << wins << " wins" << std::endl;
+  }
+}
+
+namespace {
+
+// The state shared by the racers of one puzzle.
+struct Race {
+  int size = 0;
+  const int* clues = nullptr;
+  const PortfolioOptions* options = nullptr;
+  // Receives the cells of the winner.
+  int* solution = nullptr;
+  // Ends the race once a strategy has answered.
+  std::atomic<bool> stop{false};
+  std::mutex mutex;
+  std::condition_variable finished;
+  // The index of the first strategy to answer, or -1.
+  int winner = -1;
+  // The racers queued or running.
+  int running = 0;
+  SolveStatus status[MAX_PORTFOLIO_STRATEGIES] = {};
+  SolverStats stats[MAX_PORTFOLIO_STRATEGIES] = {};
+};
+
+// The memory a thread needs to run a strategy, kept from one puzzle to
+// the next so that racing does not allocate.
+struct RacerBuffers {
+  std::vector<CandidateMask> workspace;
+  std::vector<int> cells;
+  // The answer of the races started by this thread.
+  std::vector<int> solution;
+
+  void reserve(const int size) {
+    const size_t workspace_len = solve_workspace_size(size) / sizeof(CandidateMask) + 1;
+    if (workspace.size() < workspace_len)
+      workspace.resize(workspace_len);
+    const size_t cells_len = size_t(size) * size;
+    if (cells.size() < cells_len) {
+      cells.resize(cells_len);
+      solution.resize(cells_len);
+    }
+  }
+};
+
+RacerBuffers& thread_buffers() {
+  thread_local RacerBuffers buffers;
+  return buffers;
+}
+
+// Runs a strategy on the calling thread, writing its first solution to
+// the thread's cells.
+SolveStatus run_strategy(const int size, const int* clues, const SolverOptions& options,
+                         SolverStats* stats) {
+  RacerBuffers& buffers = thread_buffers();
+  buffers.reserve(size);
+  if (options.backend == SolverBackend::CDCL)
+    return solve_clues_cdcl(size, clues, options, buffers.cells.data(), stats);
+  return solve_clues(size, clues, options, buffers.cells.data(), buffers.workspace.data(),
+                     buffers.workspace.size() * sizeof(CandidateMask), stats);
+}
+
+// Runs strategy `index` of a race on the calling thread, and records
+// its outcome.
+void run_racer(Race& race, const int index) {
+  SolverOptions solver_options = race.options->strategies[index].options;
+  solver_options.max_solutions = race.options->max_solutions;
+  solver_options.cancel = race.options->cancel;
+  solver_options.stop = &race.stop;
+  solver_options.max_nodes = 0;
+  SolverStats stats;
+  const SolveStatus status = race.stop.load() ? SolveStatus::CANCELLED :
+    run_strategy(race.size, race.clues, solver_options, &stats);
+
+  std::lock_guard<std::mutex> lock{race.mutex};
+  race.status[index] = status;
+  race.stats[index] = stats;
+  // A strategy that rejects the puzzle, for example because it is too
+  // large for it, does not end the race.
+  const bool answered = status == SolveStatus::SOLVED || status == SolveStatus::NO_SOLUTION;
+  if (answered && race.winner < 0) {
+    race.winner = index;
+    race.stop.store(true);
+    const std::vector<int>& cells = thread_buffers().cells;
+    std::copy(cells.begin(), cells.begin() + race.size * race.size, race.solution);
+  }
+  --race.running;
+  race.finished.notify_all();
+}
+
+// The threads that run the racers of every portfolio in the process,
+// so that a race neither starts threads nor allocates workspaces. The
+// thread that starts a race runs one strategy itself, and queues the
+// others here; concurrent races share the workers instead of each
+// bringing their own.
+class RacerPool {
+ public:
+  ~RacerPool() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      shutdown_ = true;
+    }
+    queued_.notify_all();
+    for (std::thread& t : workers_)
+      t.join();
+  }
+
+  // Queues strategies `first` through `last - 1` of a race, making sure
+  // that there are enough workers to run them all at once.
+  void submit(Race& race, const int first, const int last) {
+    {
+      std::lock_guard<std::mutex> race_lock{race.mutex};
+      race.running += last - first;
+    }
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (int i = first; i < last; ++i)
+      queue_.emplace_back(&race, i);
+    while (int(workers_.size()) < last - first)
+      workers_.emplace_back([this] { work(); });
+    queued_.notify_all();
+  }
+
+  // Removes the racers of a race that no worker has started yet.
+  void withdraw(Race& race) {
+    int removed = 0;
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      for (auto i = queue_.begin(); i != queue_.end();) {
+        if (i->first == &race) {
+          i = queue_.erase(i);
+          ++removed;
+        } else {
+          ++i;
+        }
+      }
+    }
+    std::lock_guard<std::mutex> race_lock{race.mutex};
+    race.running -= removed;
+  }
+
+ private:
+  void work() {
+    while (true) {
+      std::pair<Race*, int> racer;
+      {
+        std::unique_lock<std::mutex> lock{mutex_};
+        queued_.wait(lock, [this] { return shutdown_ || !queue_.empty(); });
+        if (shutdown_)
+          return;
+        racer = queue_.front();
+        queue_.pop_front();
+      }
+      run_racer(*racer.first, racer.second);
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::deque<std::pair<Race*, int>> queue_;
+  std::vector<std::thread> workers_;
+  bool shutdown_ = false;
+};
+
+RacerPool& racer_pool() {
+  static RacerPool pool;
+  return pool;
+}
+
+Board to_board(const int size, const int* cells) {
+  Board b{size};
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column)
+      b.set(cells[row * size + column], row, column);
+  }
+  return b;
+}
+
+}  // namespace
+
+std::optional<Board> solve_portfolio(const Puzzle& puzzle, const PortfolioOptions& options,
+                                     SolveStatus* status, SolverStats* stats,
+                                     PortfolioStats* portfolio_stats) {
+  TraceScope trace{"solve_portfolio"};
+  AllocPhaseScope alloc_phase{AllocPhase::SOLVING};
+  SolveStatus local_status;
+  if (status == nullptr)
+    status = &local_status;
+  SolverStats local_stats;
+  if (stats == nullptr)
+    stats = &local_stats;
+
+  const int strategies = options.strategies.size();
+  if (strategies < 1 || strategies > MAX_PORTFOLIO_STRATEGIES) {
+    *status = SolveStatus::INVALID_INPUT;
+    return std::nullopt;
+  }
+
+  const int size = puzzle.size();
+  const std::vector<int> clues = puzzle.clues();
+  RacerBuffers& buffers = thread_buffers();
+  buffers.reserve(size);
+
+  auto finish = [&](const int winner, const bool solo, const int* cells) -> std::optional<Board> {
+    if (portfolio_stats != nullptr && *status != SolveStatus::CANCELLED &&
+        *status != SolveStatus::INVALID_INPUT)
+      portfolio_stats->record(solo, winner);
+    if (*status != SolveStatus::SOLVED)
+      return std::nullopt;
+    return to_board(size, cells);
+  };
+
+  // Easy puzzles are answered by the first strategy alone, without
+  // waking up any other thread. A harder puzzle is then raced by the
+  // other strategies, so that the work of the first one is not
+  // repeated from scratch.
+  int first_racer = 0;
+  if (options.solo_nodes > 0 || strategies == 1) {
+    SolverOptions solver_options = options.strategies[0].options;
+    solver_options.max_solutions = options.max_solutions;
+    solver_options.cancel = options.cancel;
+    solver_options.max_nodes = strategies == 1 ? 0 : options.solo_nodes;
+    *status = run_strategy(size, clues.data(), solver_options, stats);
+    if (*status != SolveStatus::CANCELLED || stop_requested(solver_options) || strategies == 1)
+      return finish(0, /*solo=*/true, buffers.cells.data());
+    first_racer = 1;
+  }
+
+  Race race;
+  race.size = size;
+  race.clues = clues.data();
+  race.options = &options;
+  race.solution = buffers.solution.data();
+  if (first_racer + 1 < strategies)
+    racer_pool().submit(race, first_racer + 1, strategies);
+  {
+    std::lock_guard<std::mutex> lock{race.mutex};
+    ++race.running;
+  }
+  run_racer(race, first_racer);
+
+  // Wait for a winner, or for every racer to give up. Outside
+  // cancellation reaches the racers directly.
+  {
+    std::unique_lock<std::mutex> lock{race.mutex};
+    race.finished.wait(lock, [&race] { return race.winner >= 0 || race.running == 0; });
+  }
+  if (first_racer + 1 < strategies)
+    racer_pool().withdraw(race);
+  {
+    std::unique_lock<std::mutex> lock{race.mutex};
+    race.finished.wait(lock, [&race] { return race.running == 0; });
+  }
+
+  // Without a winner, every racer was cancelled or rejected the puzzle.
+  const int winner = race.winner >= 0 ? race.winner : first_racer;
+  *status = race.status[winner];
+  *stats = race.stats[winner];
+  return finish(winner, /*solo=*/false, race.solution);
+}
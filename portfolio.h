@@ -0,0 +1,87 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <atomic>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "board.h"
+#include "puzzle.h"
+#include "solve.h"
+
+// The most strategies a portfolio can race.
+constexpr int MAX_PORTFOLIO_STRATEGIES = 8;
+
+// A differently configured solver. Its `max_solutions`, `cancel`,
+// `stop` and `max_nodes` options are ignored; the portfolio sets them.
+struct PortfolioStrategy {
+  const char* name;
+  SolverOptions options;
+};
+
+// The strategies raced by default.
+std::vector<PortfolioStrategy> default_portfolio();
+
+struct PortfolioOptions {
+  std::vector<PortfolioStrategy> strategies = default_portfolio();
+  // How many values the first strategy may try on its own before the
+  // other strategies race. Most puzzles are solved within this budget,
+  // and then pay nothing for the other strategies. Zero races all the
+  // strategies right away.
+  long solo_nodes = 2000;
+  // As in `SolverOptions`.
+  int max_solutions = 1;
+  const std::atomic<bool>* cancel = nullptr;
+};
+
+// Counts which strategy answered each puzzle. Safe to update from
+// several threads at once.
+class PortfolioStats {
+ public:
+  // Records the outcome of a solve. `solo` tells whether the first
+  // strategy answered before the race started, and `winner` is the
+  // index of the winning strategy.
+  void record(const bool solo, const int winner);
+
+  // Prints the statistics, one strategy per line.
+  void print(std::ostream& ostream, const PortfolioOptions& options) const;
+
+ private:
+  std::atomic<long> solo_{0};
+  std::atomic<long> races_{0};
+  std::atomic<long> wins_[MAX_PORTFOLIO_STRATEGIES] = {};
+};
+
+// Solves a puzzle by racing the strategies: the calling thread runs one
+// of them, and a pool of threads shared by all portfolios in the
+// process runs the others, each thread with its own workspace. The
+// first strategy to give a complete answer wins, and the others are
+// cancelled. Since every strategy searches exhaustively, any complete
+// answer is correct, including the number of solutions up to
+// `max_solutions`. The arguments and result are as in
+// `solve_puzzle()`; `stats` are those of the winner.
+std::optional<Board> solve_portfolio(const Puzzle& puzzle, const PortfolioOptions& options,
+                                     SolveStatus* status = nullptr,
+                                     SolverStats* stats = nullptr,
+                                     PortfolioStats* portfolio_stats = nullptr);
+
+#endif
@@ -18,12 +18,11 @@
 
 #include "puzzle.h"
 
-#include <cmath>
 #include <cstdlib>
-#include <iomanip>
 #include <iostream>
 
 #include "board.h"
+#include "text_format.h"
 
 template <typename T>
 int compute_visibility(T begin, T end) {
@@ -70,25 +69,77 @@ Puzzle::Puzzle(const Board& board) : Puzzle(board.size()) {
   }
 }
 
-void Puzzle::print(std::ostream &ostream) const {
-  // Define how many digits are required, at max, to print each value in this puzzle.
-  const int value_width = std::floor(std::log10(size_)) + 1;
+Puzzle::Puzzle(const int size, const int* clues) : Puzzle(size) {
+  top_.assign(clues, clues + size_);
+  bottom_.assign(clues + size_, clues + 2 * size_);
+  left_.assign(clues + 2 * size_, clues + 3 * size_);
+  right_.assign(clues + 3 * size_, clues + 4 * size_);
+}
+
+std::vector<int> Puzzle::clues() const {
+  std::vector<int> result;
+  result.reserve(4 * size_);
+  result.insert(result.end(), top_.begin(), top_.end());
+  result.insert(result.end(), bottom_.begin(), bottom_.end());
+  result.insert(result.end(), left_.begin(), left_.end());
+  result.insert(result.end(), right_.begin(), right_.end());
+  return result;
+}
+
+// Counts the visible cells in a line of `size` cells, starting at
+// `first` and moving by `stride` cells at each step.
+static int compute_strided_visibility(const int* first, const int size, const int stride) {
+  int visible_cells = 0;
+  int highest_value = 0;
 
-  ostream << std::setw(value_width) << " ";
-  for (const int v: top_) {
-    ostream << std::setw(value_width) << v << " ";
+  for (int i = 0; i < size; ++i) {
+    const int value = first[i * stride];
+    if (value > highest_value) {
+      highest_value = value;
+      ++visible_cells;
+    }
   }
-  ostream << std::endl;
 
-  for (int row = 0; row < size_; ++row) {
-    ostream << std::setw(value_width) << left_[row]
-            << std::setw((value_width + 1) * size_ - 1) << ""
-            << std::setw(value_width) << right_[row] << std::endl;
+  return visible_cells;
+}
+
+void compute_clues(const int size, const int* cells, int* clues) {
+  int* top = clues;
+  int* bottom = clues + size;
+  int* left = clues + 2 * size;
+  int* right = clues + 3 * size;
+  const int last = size - 1;
+
+  for (int column = 0; column < size; ++column) {
+    top[column] = compute_strided_visibility(cells + column, size, size);
+    bottom[column] = compute_strided_visibility(cells + last * size + column, size, -size);
+  }
+  for (int row = 0; row < size; ++row) {
+    left[row] = compute_strided_visibility(cells + row * size, size, 1);
+    right[row] = compute_strided_visibility(cells + row * size + last, size, -1);
   }
+}
+
+void Puzzle::print(std::ostream &ostream) const {
+  TextFormatter formatter;
+  formatter.append(*this);
+  formatter.write(ostream);
+}
 
-  ostream << std::setw(value_width) << " ";
-  for (const int v: bottom_) {
-    ostream << std::setw(value_width) << v << " ";
+bool parse_clues(const char* text, const int size, std::vector<int>* clues) {
+  clues->clear();
+  const char* p = text;
+  while (true) {
+    char* end = nullptr;
+    const long value = strtol(p, &end, 10);
+    if (end == p || value < 0 || value > size)
+      return false;
+    clues->push_back(value);
+    if (*end == '\0')
+      break;
+    if (*end != ',')
+      return false;
+    p = end + 1;
   }
-  ostream << std::endl;
+  return int(clues->size()) == 4 * size;
 }
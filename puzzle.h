@@ -20,6 +20,7 @@
 #define PUZZLE_H
 
 #include <iostream>
+#include <vector>
 
 #include "board.h"
 
@@ -31,6 +32,25 @@ public:
   // Creates a puzzle based on an existing, solved board.
   explicit Puzzle(const Board& board);
 
+  // Creates a puzzle from a flat array of 4 * size clues, laid out as
+  // top, bottom, left and right (see `clues()`). A zero clue means
+  // that no clue is given for that line.
+  Puzzle(const int size, const int* clues);
+
+  // Retrieves the puzzle size.
+  int size() const { return size_; }
+
+  // Accessors for the clues on each side of the board. Top and bottom
+  // clues are indexed by column, left and right clues by row.
+  const std::vector<int>& top() const { return top_; }
+  const std::vector<int>& bottom() const { return bottom_; }
+  const std::vector<int>& left() const { return left_; }
+  const std::vector<int>& right() const { return right_; }
+
+  // Returns all the clues as a flat array of 4 * size values, laid
+  // out as top, bottom, left and right.
+  std::vector<int> clues() const;
+
   // Prints the puzzle to the provided output stream.
   void print(std::ostream &ostream) const;
 
@@ -43,4 +63,13 @@ private:
   std::vector<int> right_;
 };
 
+// Computes the clues of a solved board stored as `size * size` cells
+// in row-major order, and writes them to `clues` with the same layout
+// as `Puzzle::clues()`. Does not allocate.
+void compute_clues(const int size, const int* cells, int* clues);
+
+// Parses a comma-separated list of exactly 4 * size clues between 0
+// and size, laid out as in `Puzzle::clues()`.
+bool parse_clues(const char* text, const int size, std::vector<int>* clues);
+
 #endif
@@ -0,0 +1,277 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "puzzle_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cdcl.h"
+#include "options.h"
+#include "solve.h"
+
+namespace {
+
+// Smaller inputs are not worth splitting any further.
+constexpr size_t MIN_BYTES_PER_WORKER = 1 << 20;
+
+bool is_blank(const char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Returns the start of the line after the one containing `p`.
+const char* next_line(const char* p, const char* end) {
+  const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+  return newline == nullptr ? end : newline + 1;
+}
+
+// Returns whether the line starting at `p` holds only whitespace.
+bool is_blank_line(const char* p, const char* end) {
+  while (p < end && is_blank(*p))
+    ++p;
+  return p == end || *p == '\n';
+}
+
+// Reads the integers of the line starting at `p`, up to `max` of them,
+// and moves `p` to the next line. Returns how many were read, or -1 if
+// the line holds anything else or more than `max` integers.
+int scan_line(const char*& p, const char* end, int* values, const int max) {
+  int count = 0;
+  while (p < end && *p != '\n') {
+    if (is_blank(*p)) {
+      ++p;
+      continue;
+    }
+    if (*p < '0' || *p > '9' || count == max)
+      return -1;
+    int value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+      value = value * 10 + (*p - '0');
+      if (value > MAX_PARSED_SIZE)
+        return -1;
+      ++p;
+    }
+    values[count++] = value;
+  }
+  if (p < end)
+    ++p;
+  return count;
+}
+
+// Moves `p` past the next empty line, so that it starts a puzzle.
+const char* skip_to_puzzle(const char* p, const char* end) {
+  while (p < end) {
+    const bool blank = is_blank_line(p, end);
+    p = next_line(p, end);
+    if (blank)
+      break;
+  }
+  return p;
+}
+
+// Parses the puzzles in [begin, end), which starts at a puzzle
+// boundary. Returns false, after reporting it, on a malformed puzzle.
+bool parse_range(const char* base, const char* begin, const char* end, const int worker,
+                 const PuzzleConsumer& consumer, std::atomic<bool>& stop,
+                 uint64_t* count) {
+  int clues[4 * MAX_PARSED_SIZE];
+  int pair[2];
+  const char* p = begin;
+  while (!stop.load(std::memory_order_relaxed)) {
+    while (p < end && is_blank_line(p, end))
+      p = next_line(p, end);
+    if (p == end)
+      return true;
+
+    // The top clues give the size; then come the left and right clues
+    // of each row, and the bottom clues.
+    const char* puzzle = p;
+    const int size = scan_line(p, end, clues, MAX_PARSED_SIZE);
+    bool ok = size > 0;
+    for (int row = 0; ok && row < size; ++row) {
+      ok = scan_line(p, end, pair, 2) == 2;
+      clues[2 * size + row] = pair[0];
+      clues[3 * size + row] = pair[1];
+    }
+    ok = ok && scan_line(p, end, clues + size, size) == size;
+    for (int i = 0; ok && i < 4 * size; ++i)
+      ok = clues[i] <= size;
+    if (!ok) {
+      std::cerr << "ERROR: malformed puzzle at byte " << puzzle - base << std::endl;
+      return false;
+    }
+
+    ++*count;
+    if (!consumer(worker, puzzle - base, size, clues)) {
+      stop.store(true);
+      return true;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+std::optional<uint64_t> parse_puzzle_file(const char* path, const int threads,
+                                          const PuzzleConsumer& consumer) {
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "ERROR: cannot open puzzle file: " << path << std::endl;
+    return std::nullopt;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    std::cerr << "ERROR: cannot read puzzle file: " << path << std::endl;
+    close(fd);
+    return std::nullopt;
+  }
+  const size_t length = st.st_size;
+  if (length == 0) {
+    close(fd);
+    return 0;
+  }
+  void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "ERROR: cannot map puzzle file: " << path << std::endl;
+    return std::nullopt;
+  }
+  madvise(mapping, length, MADV_SEQUENTIAL);
+
+  // Split the file in equal parts, moving each boundary forward to the
+  // start of the next puzzle.
+  const char* base = static_cast<const char*>(mapping);
+  const char* end = base + length;
+  const int workers = std::max<size_t>(1, std::min<size_t>(threads, length / MIN_BYTES_PER_WORKER));
+  std::vector<const char*> bounds{base};
+  for (int i = 1; i < workers; ++i) {
+    const char* p = base + length / workers * i;
+    bounds.push_back(std::max(bounds.back(), skip_to_puzzle(next_line(p - 1, end), end)));
+  }
+  bounds.push_back(end);
+
+  std::atomic<bool> stop{false};
+  std::atomic<bool> failed{false};
+  std::vector<uint64_t> counts(workers, 0);
+  auto work = [&](const int worker) {
+    if (!parse_range(base, bounds[worker], bounds[worker + 1], worker, consumer, stop,
+                     &counts[worker])) {
+      failed.store(true);
+      stop.store(true);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int i = 1; i < workers; ++i)
+    pool.emplace_back(work, i);
+  work(0);
+  for (std::thread& t : pool)
+    t.join();
+  munmap(mapping, length);
+
+  if (failed.load())
+    return std::nullopt;
+  uint64_t total = 0;
+  for (const uint64_t count : counts)
+    total += count;
+  return total;
+}
+
+namespace {
+
+// What batch solving found, for the puzzles of one worker.
+struct alignas(64) BatchCounts {
+  uint64_t unique = 0;
+  uint64_t multiple = 0;
+  uint64_t unsolvable = 0;
+  // Too large for the solver.
+  uint64_t skipped = 0;
+};
+
+}  // namespace
+
+int run_batch_solve(const ProgramOptions& options) {
+  const int threads = resolve_thread_count(options.create_options.pipeline.generator_threads);
+
+  SolverOptions solver_options;
+  solver_options.max_solutions = 2;
+  // Each worker owns a workspace, grown to fit the largest puzzle it
+  // has seen, and a solution buffer.
+  std::vector<std::vector<unsigned char>> workspaces(threads);
+  std::vector<std::vector<int>> solutions(threads);
+  std::vector<BatchCounts> counts(threads);
+  const std::optional<uint64_t> total = parse_puzzle_file(
+    options.batch_options.puzzle_file, threads,
+    [&](const int worker, const size_t, const int size, const int* clues) {
+      BatchCounts& c = counts[worker];
+      std::vector<int>& solution = solutions[worker];
+      if (solution.size() < size_t(size * size))
+        solution.resize(size * size);
+      SolverStats stats;
+      SolveStatus status;
+      if (pick_backend(options.solver_backend, size) == SolverBackend::CDCL) {
+        status = solve_clues_cdcl(size, clues, solver_options, solution.data(), &stats);
+      } else {
+        std::vector<unsigned char>& workspace = workspaces[worker];
+        if (workspace.size() < solve_workspace_size(size))
+          workspace.resize(solve_workspace_size(size));
+        status = solve_clues(size, clues, solver_options, solution.data(), workspace.data(),
+                             workspace.size(), &stats);
+      }
+      switch (status) {
+      case SolveStatus::SOLVED:
+        ++(stats.solutions == 1 ? c.unique : c.multiple);
+        break;
+      case SolveStatus::NO_SOLUTION:
+        ++c.unsolvable;
+        break;
+      case SolveStatus::CANCELLED:
+      case SolveStatus::INVALID_INPUT:
+        ++c.skipped;
+        break;
+      }
+      return true;
+    });
+  if (!total.has_value())
+    return EXIT_FAILURE;
+
+  BatchCounts sum;
+  for (const BatchCounts& c : counts) {
+    sum.unique += c.unique;
+    sum.multiple += c.multiple;
+    sum.unsolvable += c.unsolvable;
+    sum.skipped += c.skipped;
+  }
+  std::ofstream out{options.puzzle_output_file, std::ios::out};
+  out << "Puzzles: " << *total << std::endl
+      << "Unique solution: " << sum.unique << std::endl
+      << "Multiple solutions: " << sum.multiple << std::endl
+      << "No solution: " << sum.unsolvable << std::endl;
+  if (sum.skipped > 0)
+    out << "Not solved (too large): " << sum.skipped << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,54 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PUZZLE_FILE_H
+#define PUZZLE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+#include "options.h"
+
+// The largest puzzle the parser accepts.
+constexpr int MAX_PARSED_SIZE = 64;
+
+// Receives one parsed puzzle: the index of the worker thread that
+// parsed it (below the thread count), the byte offset of the puzzle in
+// the file, which orders the puzzles, its size, and its 4 * size clues
+// laid out as in `Puzzle::clues()`. The clues are only valid during
+// the call. Workers call it concurrently; returning false stops all
+// of them.
+using PuzzleConsumer =
+  std::function<bool(const int worker, const size_t offset, const int size, const int* clues)>;
+
+// Reads a file of puzzles in the format written by `Puzzle::print()`,
+// separated by empty lines, as written by bulk creation. The file is
+// memory-mapped and split across up to `threads` workers at puzzle
+// boundaries; puzzles are tokenized in place, without allocating.
+// Returns the number of puzzles handed to the consumer, or nothing if
+// the file cannot be read or a puzzle is malformed.
+std::optional<uint64_t> parse_puzzle_file(const char* path, const int threads,
+                                          const PuzzleConsumer& consumer);
+
+// Entry point for the --solve-file program mode. Returns a value
+// compatible with 'man 3 exit'.
+int run_batch_solve(const ProgramOptions& options);
+
+#endif
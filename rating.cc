@@ -0,0 +1,99 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rating.h"
+
+#include <cstring>
+
+#include "solve.h"
+
+namespace {
+
+constexpr const char* DIFFICULTY_NAMES[] = {"unspecified", "easy", "medium", "hard", "expert"};
+
+// The hardest rule allowed at each difficulty below EXPERT.
+DeductionRule max_rule(const Difficulty difficulty) {
+  switch (difficulty) {
+  case Difficulty::EASY:
+    return DeductionRule::HIDDEN_SINGLE;
+  case Difficulty::MEDIUM:
+    return DeductionRule::VISIBILITY;
+  default:
+    return DeductionRule::LINE_ARRANGEMENT;
+  }
+}
+
+std::optional<Difficulty> parse_difficulty(const char* text, const size_t length) {
+  for (int i = int(Difficulty::EASY); i <= int(Difficulty::EXPERT); ++i) {
+    if (strlen(DIFFICULTY_NAMES[i]) == length && strncmp(text, DIFFICULTY_NAMES[i], length) == 0)
+      return Difficulty(i);
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+const char* difficulty_name(const Difficulty difficulty) {
+  return DIFFICULTY_NAMES[int(difficulty)];
+}
+
+std::optional<DifficultyBand> parse_difficulty_band(const char* text) {
+  const char* dash = strchr(text, '-');
+  const size_t first_length = dash == nullptr ? strlen(text) : dash - text;
+  const std::optional<Difficulty> min = parse_difficulty(text, first_length);
+  const std::optional<Difficulty> max =
+    dash == nullptr ? min : parse_difficulty(dash + 1, strlen(dash + 1));
+  if (!min.has_value() || !max.has_value() || *min > *max)
+    return std::nullopt;
+  return DifficultyBand{*min, *max};
+}
+
+bool rate_clues(const int size, const int* clues, const DifficultyBand& band, void* workspace,
+                const size_t workspace_len, Rating* rating) {
+  *rating = Rating{};
+  SolverState state{size, clues, workspace, workspace_len};
+  if (!state.ok())
+    return false;
+
+  Difficulty level = Difficulty::EASY;
+  state.set_max_rule(max_rule(level));
+  bool consistent = state.initialize();
+  while (true) {
+    rating->rounds = state.rounds();
+    if (!consistent)
+      // No solution at all.
+      return false;
+    if (state.complete()) {
+      rating->difficulty = level;
+      return level >= band.min;
+    }
+    if (level == Difficulty::HARD) {
+      rating->difficulty = Difficulty::EXPERT;
+      rating->guessed = true;
+      return band.max == Difficulty::EXPERT;
+    }
+    if (level >= band.max) {
+      // Harder than the band, whatever the rules that would solve it.
+      rating->difficulty = Difficulty(int(level) + 1);
+      return false;
+    }
+    level = Difficulty(int(level) + 1);
+    state.set_max_rule(max_rule(level));
+    consistent = state.propagate();
+  }
+}
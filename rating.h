@@ -0,0 +1,58 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RATING_H
+#define RATING_H
+
+#include <cstddef>
+#include <optional>
+
+#include "options.h"
+
+// How a logic-only solver fared on a puzzle.
+struct Rating {
+  // The easiest difficulty whose rules solve the puzzle, or EXPERT if
+  // none does. If the rating was cut short, a lower bound.
+  Difficulty difficulty = Difficulty::UNSPECIFIED;
+  // Rounds of line checks run by propagation.
+  long rounds = 0;
+  // Whether the rules could not finish the puzzle, so that solving it
+  // requires guessing.
+  bool guessed = false;
+};
+
+// Returns a short human-readable name for a difficulty.
+const char* difficulty_name(const Difficulty difficulty);
+
+// Parses a difficulty name, or a range of them such as "easy-medium".
+std::optional<DifficultyBand> parse_difficulty_band(const char* text);
+
+// Rates a puzzle with 4 * size clues, laid out as in `Puzzle::clues()`,
+// enabling harder rules one level at a time on the same solver state.
+// Returns whether the difficulty falls within the band, and stops as
+// soon as the answer is known: when the puzzle is solved below the
+// band, or gets stuck at its top.
+//
+// A puzzle solved by the rules has a unique solution. Puzzles rated
+// EXPERT may have several, which the caller must rule out by search.
+// The solver state lives in `workspace`, of at least
+// `SolverState::workspace_size(size)` bytes, and nothing is allocated.
+bool rate_clues(const int size, const int* clues, const DifficultyBand& band, void* workspace,
+                const size_t workspace_len, Rating* rating);
+
+#endif
@@ -0,0 +1,198 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "shard.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "create.h"
+
+namespace {
+
+// The current record of one input of a merge.
+struct MergeInput {
+  const char* path;
+  std::ifstream stream;
+  std::string line;
+  uint64_t seed = 0;
+  uint64_t line_number = 0;
+};
+
+// Reads the next record of an input. Returns false at the end of the
+// input, and sets `error` if the record is malformed or out of order.
+bool advance(MergeInput& input, bool* error) {
+  const uint64_t previous = input.seed;
+  const bool first = input.line_number == 0;
+  while (std::getline(input.stream, input.line)) {
+    ++input.line_number;
+    if (input.line.empty())
+      continue;
+    const char* text = input.line.c_str();
+    char* end = nullptr;
+    errno = 0;
+    input.seed = strtoull(text, &end, 10);
+    if (end == text || *end != ' ' || errno != 0) {
+      std::cerr << "ERROR: malformed record on line " << input.line_number << " of "
+                << input.path << std::endl;
+      *error = true;
+      return false;
+    }
+    if (!first && input.seed < previous) {
+      std::cerr << "ERROR: records are not sorted by seed on line " << input.line_number
+                << " of " << input.path << std::endl;
+      *error = true;
+      return false;
+    }
+    return true;
+  }
+  if (input.stream.bad()) {
+    std::cerr << "ERROR: cannot read record file: " << input.path << std::endl;
+    *error = true;
+  }
+  return false;
+}
+
+}  // namespace
+
+uint64_t shard_first_seed(const uint32_t index, const uint32_t count) {
+  return uint64_t((static_cast<unsigned __int128>(index) << 64) / count);
+}
+
+bool parse_shard(const char* text, uint32_t* index, uint32_t* count) {
+  char* end = nullptr;
+  const unsigned long i = strtoul(text, &end, 10);
+  if (end == text || *end != '/')
+    return false;
+  const char* rest = end + 1;
+  const unsigned long n = strtoul(rest, &end, 10);
+  if (end == rest || *end != '\0' || n == 0 || n > UINT32_MAX || i >= n)
+    return false;
+  *index = i;
+  *count = n;
+  return true;
+}
+
+void write_record(std::ostream& ostream, const uint64_t seed, const CreateMode mode,
+                  const Board& board, const Puzzle& puzzle) {
+  const int size = board.size();
+  ostream << seed << ' ' << create_mode_name(mode) << ' ' << size << ' ';
+  const std::vector<int>* sides[] = {&puzzle.top(), &puzzle.bottom(), &puzzle.left(),
+                                     &puzzle.right()};
+  char separator = '\0';
+  for (const std::vector<int>* side : sides) {
+    for (const int clue : *side) {
+      if (separator != '\0')
+        ostream << separator;
+      ostream << clue;
+      separator = ',';
+    }
+  }
+  separator = ' ';
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column) {
+      ostream << separator << board.at(row, column);
+      separator = ',';
+    }
+  }
+  ostream << '\n';
+}
+
+bool merge_records(const char* const* inputs, const int input_count, std::ostream& ostream,
+                   uint64_t* merged, uint64_t* duplicates) {
+  *merged = 0;
+  *duplicates = 0;
+  std::vector<std::unique_ptr<MergeInput>> sources;
+  for (int i = 0; i < input_count; ++i) {
+    auto input = std::make_unique<MergeInput>();
+    input->path = inputs[i];
+    input->stream.open(inputs[i]);
+    if (!input->stream) {
+      std::cerr << "ERROR: cannot open record file: " << inputs[i] << std::endl;
+      return false;
+    }
+    sources.push_back(std::move(input));
+  }
+
+  // A min-heap of the inputs by their current seed; ties go to the
+  // earlier input, so that the output does not depend on timing.
+  auto later = [&sources](const int a, const int b) {
+    return sources[a]->seed != sources[b]->seed ? sources[a]->seed > sources[b]->seed : a > b;
+  };
+  std::priority_queue<int, std::vector<int>, decltype(later)> heap{later};
+  bool error = false;
+  for (int i = 0; i < input_count; ++i) {
+    if (advance(*sources[i], &error))
+      heap.push(i);
+    if (error)
+      return false;
+  }
+
+  // The records written with the current seed. The same seed may
+  // create different boards in other modes or sizes, so only identical
+  // records are duplicates.
+  std::unordered_set<std::string> written;
+  uint64_t last_seed = 0;
+  while (!heap.empty()) {
+    const int i = heap.top();
+    heap.pop();
+    MergeInput& input = *sources[i];
+    if (input.seed != last_seed)
+      written.clear();
+    last_seed = input.seed;
+    if (!written.insert(input.line).second) {
+      ++*duplicates;
+    } else {
+      ostream << input.line << '\n';
+      ++*merged;
+    }
+    if (advance(input, &error))
+      heap.push(i);
+    if (error)
+      return false;
+  }
+  ostream.flush();
+  if (!ostream) {
+    std::cerr << "ERROR: cannot write the merged records" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int run_merge(const ProgramOptions& options) {
+  const MergeOptions& merge_options = options.merge_options;
+  if (merge_options.input_count == 0) {
+    std::cerr << "ERROR: no record files to merge" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::ofstream out{options.puzzle_output_file, std::ios::out};
+  uint64_t merged;
+  uint64_t duplicates;
+  if (!merge_records(merge_options.inputs, merge_options.input_count, out, &merged, &duplicates))
+    return EXIT_FAILURE;
+  std::cerr << "Merged " << merged << " records, dropped " << duplicates << " duplicates"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
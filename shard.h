@@ -0,0 +1,57 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "board.h"
+#include "options.h"
+#include "puzzle.h"
+
+// Returns the first seed of shard `index` out of `count`. The shards
+// split the 64-bit seed space into equal, disjoint ranges, and the
+// n-th board of a shard uses 'first seed + --seed + n', where --seed
+// defaults to 0.
+uint64_t shard_first_seed(const uint32_t index, const uint32_t count);
+
+// Parses a shard specification such as "3/8". Returns false if it is
+// malformed, or if the index is not below the count.
+bool parse_shard(const char* text, uint32_t* index, uint32_t* count);
+
+// Writes a record: one line holding the seed, the creation mode, the
+// size, the clues and the solution, the latter two comma-separated as
+// for --lookup.
+void write_record(std::ostream& ostream, const uint64_t seed, const CreateMode mode,
+                  const Board& board, const Puzzle& puzzle);
+
+// Merges files of records, each sorted by seed, into a single stream
+// sorted by seed, keeping only the first of identical records. Only one
+// record per input, and the distinct records of the current seed, are
+// held in memory at a time. Returns false if an input cannot be read or
+// is not sorted.
+bool merge_records(const char* const* inputs, const int input_count, std::ostream& ostream,
+                   uint64_t* merged, uint64_t* duplicates);
+
+// Entry point for the --merge program mode. Returns a value
+// compatible with 'man 3 exit'.
+int run_merge(const ProgramOptions& options);
+
+#endif
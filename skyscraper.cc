@@ -0,0 +1,178 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "skyscraper.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <random>
+
+#include "board.h"
+#include "create.h"
+#include "dlx.h"
+#include "puzzle.h"
+#include "solve.h"
+
+namespace {
+
+// Maps the outcome of the solver to a C API status.
+int to_status(const SolveStatus status) {
+  switch (status) {
+  case SolveStatus::SOLVED:
+    return SKYSCRAPER_OK;
+  case SolveStatus::NO_SOLUTION:
+    return SKYSCRAPER_NO_SOLUTION;
+  case SolveStatus::INVALID_INPUT:
+    return SKYSCRAPER_INVALID_ARGUMENT;
+  case SolveStatus::CANCELLED:
+    break;
+  }
+  return SKYSCRAPER_INTERNAL_ERROR;
+}
+
+// Maps a C API creation mode to the internal one.
+CreateMode to_create_mode(const int mode) {
+  switch (mode) {
+  case SKYSCRAPER_CREATE_SHUFFLE:
+    return CreateMode::SHUFFLE;
+  case SKYSCRAPER_CREATE_RANDOM:
+    return CreateMode::RANDOM;
+  case SKYSCRAPER_CREATE_DLX:
+    return CreateMode::DLX;
+  }
+  return CreateMode::UNSPECIFIED;
+}
+
+}  // namespace
+
+extern "C" int skyscraper_create(int mode, uint16_t size, uint32_t seed,
+                                 int* board, size_t board_len,
+                                 int* clues, size_t clues_len) {
+  if (size <= 1)
+    return SKYSCRAPER_INVALID_ARGUMENT;
+  const size_t cells = size_t(size) * size;
+  if ((board != nullptr && board_len < cells) || (clues != nullptr && clues_len < 4 * size_t(size)))
+    return SKYSCRAPER_BUFFER_TOO_SMALL;
+
+  // Exceptions must not cross the C boundary.
+  try {
+    const CreateMode create_mode = to_create_mode(mode);
+    if (create_mode == CreateMode::UNSPECIFIED)
+      return SKYSCRAPER_INVALID_ARGUMENT;
+    std::mt19937 generator{seed};
+    const std::optional<Board> b = run_creation_algorithm(create_mode, size, generator);
+    if (!b.has_value())
+      return SKYSCRAPER_INTERNAL_ERROR;
+
+    if (board != nullptr) {
+      for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column)
+          board[row * size + column] = b->at(row, column);
+      }
+    }
+    if (clues != nullptr) {
+      const std::vector<int> all = Puzzle{*b}.clues();
+      std::copy(all.begin(), all.end(), clues);
+    }
+  } catch (const std::bad_alloc&) {
+    return SKYSCRAPER_INTERNAL_ERROR;
+  }
+  return SKYSCRAPER_OK;
+}
+
+extern "C" size_t skyscraper_create_workspace_size(uint16_t size) {
+  if (size <= 1)
+    return 0;
+  // The arena of the search, then the cells it fills in.
+  return LatinSquareCover::workspace_size(size) + size_t(size) * size * sizeof(int);
+}
+
+extern "C" int skyscraper_create_dlx(uint16_t size, uint32_t seed,
+                                     int* board, size_t board_len,
+                                     int* clues, size_t clues_len,
+                                     void* workspace, size_t workspace_len) {
+  if (size <= 1 || workspace == nullptr || reinterpret_cast<uintptr_t>(workspace) % 8 != 0)
+    return SKYSCRAPER_INVALID_ARGUMENT;
+  const size_t cells = size_t(size) * size;
+  if ((board != nullptr && board_len < cells) || (clues != nullptr && clues_len < 4 * size_t(size)) ||
+      workspace_len < skyscraper_create_workspace_size(size))
+    return SKYSCRAPER_BUFFER_TOO_SMALL;
+
+  const size_t arena_len = LatinSquareCover::workspace_size(size);
+  int* solution = board != nullptr ? board :
+    reinterpret_cast<int*>(static_cast<char*>(workspace) + arena_len);
+  LatinSquareCover cover{size, workspace};
+  std::mt19937 generator{seed};
+  if (!cover.solve(&generator, solution))
+    return SKYSCRAPER_INTERNAL_ERROR;
+  if (clues != nullptr)
+    compute_clues(size, solution, clues);
+  return SKYSCRAPER_OK;
+}
+
+extern "C" int skyscraper_compute_clues(uint16_t size, const int* board, size_t board_len,
+                                        int* clues, size_t clues_len) {
+  if (size <= 0 || board == nullptr || clues == nullptr)
+    return SKYSCRAPER_INVALID_ARGUMENT;
+  if (board_len < size_t(size) * size || clues_len < 4 * size_t(size))
+    return SKYSCRAPER_BUFFER_TOO_SMALL;
+
+  compute_clues(size, board, clues);
+  return SKYSCRAPER_OK;
+}
+
+extern "C" size_t skyscraper_solve_workspace_size(uint16_t size) {
+  return solve_workspace_size(size);
+}
+
+extern "C" int skyscraper_solve(uint16_t size, const int* clues, size_t clues_len,
+                                int* board, size_t board_len,
+                                void* workspace, size_t workspace_len) {
+  int count = 0;
+  return skyscraper_count_solutions(size, clues, clues_len, /*limit=*/1, &count,
+                                    board, board_len, workspace, workspace_len);
+}
+
+extern "C" int skyscraper_count_solutions(uint16_t size, const int* clues, size_t clues_len,
+                                          int limit, int* count,
+                                          int* board, size_t board_len,
+                                          void* workspace, size_t workspace_len) {
+  if (size <= 0 || size > MAX_SOLVER_SIZE || clues == nullptr || count == nullptr || limit < 1)
+    return SKYSCRAPER_INVALID_ARGUMENT;
+  if (clues_len < 4 * size_t(size))
+    return SKYSCRAPER_BUFFER_TOO_SMALL;
+  if (workspace_len < solve_workspace_size(size))
+    return SKYSCRAPER_BUFFER_TOO_SMALL;
+
+  if (board != nullptr && board_len < size_t(size) * size)
+    return SKYSCRAPER_BUFFER_TOO_SMALL;
+  // The solver always writes the first solution, even when the
+  // caller only wants the count.
+  int scratch[MAX_SOLVER_SIZE * MAX_SOLVER_SIZE];
+  int* solution = board != nullptr ? board : scratch;
+
+  SolverOptions options;
+  options.max_solutions = limit;
+  SolverStats stats;
+  const SolveStatus status = solve_clues(size, clues, options, solution,
+                                         workspace, workspace_len, &stats);
+  *count = stats.solutions;
+  return to_status(status);
+}
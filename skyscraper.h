@@ -0,0 +1,131 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * C interface to libskyscraper, for embedding the generator and the
+ * solver in other programs.
+ *
+ * Boards are passed as `size * size` ints in row-major order. Clues
+ * are passed as `4 * size` ints: the top clues (by column), then the
+ * bottom clues (by column), the left clues (by row) and the right
+ * clues (by row). A zero clue means that no clue is given.
+ *
+ * All results are written into caller-provided buffers; the library
+ * never returns memory that the caller has to release. Only
+ * `skyscraper_create()` allocates while it runs; the other calls work
+ * in caller-provided workspaces.
+ */
+
+#ifndef SKYSCRAPER_H
+#define SKYSCRAPER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum skyscraper_status {
+  SKYSCRAPER_OK = 0,
+  /* A parameter is out of range. */
+  SKYSCRAPER_INVALID_ARGUMENT = 1,
+  /* A caller-provided buffer is too small. */
+  SKYSCRAPER_BUFFER_TOO_SMALL = 2,
+  /* The clues admit no solution. */
+  SKYSCRAPER_NO_SOLUTION = 3,
+  /* Something unexpected happened inside the library. */
+  SKYSCRAPER_INTERNAL_ERROR = 4,
+};
+
+enum skyscraper_create_mode {
+  SKYSCRAPER_CREATE_SHUFFLE = 1,
+  SKYSCRAPER_CREATE_RANDOM = 2,
+  SKYSCRAPER_CREATE_DLX = 3,
+};
+
+/*
+ * Creates a board of the given size with the given mode and seed, and
+ * writes the board to `board` and its clues to `clues`. Either output
+ * may be NULL if it is not needed. The same seed always produces the
+ * same board.
+ *
+ * Unlike the other calls, this one allocates: the generators build the
+ * board in internal, heap-backed state, and copy it out at the end.
+ * Allocation failures are reported as SKYSCRAPER_INTERNAL_ERROR.
+ */
+int skyscraper_create(int mode, uint16_t size, uint32_t seed,
+                      int* board, size_t board_len,
+                      int* clues, size_t clues_len);
+
+/*
+ * Returns the size in bytes of the workspace needed to create a board
+ * of the given size with `skyscraper_create_dlx()`, or zero if the size
+ * is not supported.
+ */
+size_t skyscraper_create_workspace_size(uint16_t size);
+
+/*
+ * Same as `skyscraper_create()` with SKYSCRAPER_CREATE_DLX, and the
+ * same seed gives the same board, but the search runs inside the
+ * caller's workspace. The workspace must be at least
+ * `skyscraper_create_workspace_size(size)` bytes and aligned to 8
+ * bytes (e.g. obtained from malloc). Does not allocate.
+ */
+int skyscraper_create_dlx(uint16_t size, uint32_t seed,
+                          int* board, size_t board_len,
+                          int* clues, size_t clues_len,
+                          void* workspace, size_t workspace_len);
+
+/*
+ * Computes the clues of a solved board. Does not allocate.
+ */
+int skyscraper_compute_clues(uint16_t size, const int* board, size_t board_len,
+                             int* clues, size_t clues_len);
+
+/*
+ * Returns the size in bytes of the workspace needed to solve a puzzle
+ * of the given size, or zero if the size is not supported.
+ */
+size_t skyscraper_solve_workspace_size(uint16_t size);
+
+/*
+ * Solves a puzzle, writing its solution to `board`. The workspace
+ * must be at least `skyscraper_solve_workspace_size(size)` bytes and
+ * aligned to 8 bytes (e.g. obtained from malloc). Does not allocate.
+ */
+int skyscraper_solve(uint16_t size, const int* clues, size_t clues_len,
+                     int* board, size_t board_len,
+                     void* workspace, size_t workspace_len);
+
+/*
+ * Counts the solutions of a puzzle, stopping at `limit`. With a limit
+ * of 2, a count of 1 means that the solution is unique. The first
+ * solution is written to `board`, unless it is NULL. The workspace
+ * is the same as for `skyscraper_solve()`. Does not allocate.
+ */
+int skyscraper_count_solutions(uint16_t size, const int* clues, size_t clues_len,
+                               int limit, int* count,
+                               int* board, size_t board_len,
+                               void* workspace, size_t workspace_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,612 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "solution_store.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "options.h"
+#include "portfolio.h"
+#include "puzzle.h"
+#include "solve.h"
+#include "symmetry.h"
+
+namespace {
+
+constexpr char STORE_MAGIC[8] = {'S', 'K', 'Y', 'S', 'T', 'O', 'R', 'E'};
+constexpr uint32_t STORE_VERSION = 2;
+
+// Number of Latin squares of each size, which is also the number of
+// boards. Used to check the enumeration.
+constexpr uint64_t LATIN_SQUARES[MAX_STORE_SIZE + 1] = {0, 1, 2, 12, 576, 161280, 812851200};
+
+// The table grows by this factor whenever the next batch of boards
+// could take it past MAX_LOAD. It ends up between MAX_LOAD / GROWTH
+// and MAX_LOAD full.
+constexpr double MAX_LOAD = 0.7;
+constexpr double GROWTH = 1.5;
+
+struct StoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t size;
+  // Number of slots.
+  uint64_t capacity;
+  // Number of distinct clue sets stored.
+  uint64_t entries;
+  uint64_t padding[4];
+};
+static_assert(sizeof(StoreHeader) == 64);
+
+// Both the clues and the solution are packed at 3 bits per value.
+// The top bits of the second key word are not needed for the clues,
+// and hold the state of the slot instead.
+struct StoreEntry {
+  uint64_t key[2];
+  uint64_t solution[2];
+};
+constexpr uint64_t SLOT_OCCUPIED = uint64_t(1) << 63;
+constexpr uint64_t SLOT_BUSY = uint64_t(1) << 62;
+constexpr uint64_t SLOT_MULTIPLE = uint64_t(1) << 61;
+constexpr uint64_t SLOT_FLAGS = SLOT_OCCUPIED | SLOT_BUSY | SLOT_MULTIPLE;
+
+constexpr int BITS_PER_VALUE = 3;
+
+void pack(const int* values, const int count, uint64_t* words) {
+  words[0] = words[1] = 0;
+  for (int i = 0; i < count; ++i) {
+    const int bit = i * BITS_PER_VALUE;
+    const uint64_t v = values[i];
+    words[bit / 64] |= v << (bit % 64);
+    if (bit % 64 > 64 - BITS_PER_VALUE)
+      // The value straddles the two words.
+      words[1] |= v >> (64 - bit % 64);
+  }
+}
+
+void unpack(const uint64_t* words, const int count, int* values) {
+  for (int i = 0; i < count; ++i) {
+    const int bit = i * BITS_PER_VALUE;
+    uint64_t v = words[bit / 64] >> (bit % 64);
+    if (bit % 64 > 64 - BITS_PER_VALUE)
+      v |= words[1] << (64 - bit % 64);
+    values[i] = v & ((1 << BITS_PER_VALUE) - 1);
+  }
+}
+
+uint64_t hash_key(const uint64_t* key) {
+  // splitmix64 finalizer over both words.
+  uint64_t h = key[0] ^ (key[1] * 0x9e3779b97f4a7c15ULL);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+// Maps a hash to a slot, for any capacity.
+uint64_t home_slot(const uint64_t* key, const uint64_t capacity) {
+  return uint64_t((static_cast<unsigned __int128>(hash_key(key)) * capacity) >> 64);
+}
+
+uint64_t next_slot(const uint64_t slot, const uint64_t capacity) {
+  return slot + 1 == capacity ? 0 : slot + 1;
+}
+
+StoreHeader* header_of(void* mapping) {
+  return static_cast<StoreHeader*>(mapping);
+}
+
+StoreEntry* entries_of(void* mapping) {
+  return reinterpret_cast<StoreEntry*>(static_cast<char*>(mapping) + sizeof(StoreHeader));
+}
+
+// Inserts a board into the table, or marks the existing entry with
+// the same clues as having multiple solutions. Safe to call from
+// several threads at once.
+void insert(StoreEntry* entries, const uint64_t capacity, const uint64_t* key,
+            const uint64_t* solution, std::atomic<uint64_t>& entry_count) {
+  for (uint64_t slot = home_slot(key, capacity); ; slot = next_slot(slot, capacity)) {
+    StoreEntry& e = entries[slot];
+    std::atomic_ref<uint64_t> state{e.key[1]};
+    uint64_t current = 0;
+    if (state.compare_exchange_strong(current, SLOT_BUSY, std::memory_order_acq_rel)) {
+      // The slot was free and is now ours to fill in.
+      e.key[0] = key[0];
+      e.solution[0] = solution[0];
+      e.solution[1] = solution[1];
+      state.store(key[1] | SLOT_OCCUPIED, std::memory_order_release);
+      entry_count.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    while (current & SLOT_BUSY) {
+      std::this_thread::yield();
+      current = state.load(std::memory_order_acquire);
+    }
+    if (e.key[0] == key[0] && (current & ~SLOT_FLAGS) == key[1]) {
+      state.fetch_or(SLOT_MULTIPLE, std::memory_order_relaxed);
+      return;
+    }
+  }
+}
+
+// Moves an entry into a table that cannot hold its key yet, keeping
+// its flags. Safe to call from several threads at once.
+void move_entry(StoreEntry* entries, const uint64_t capacity, const StoreEntry& entry) {
+  const uint64_t key[2] = {entry.key[0], entry.key[1] & ~SLOT_FLAGS};
+  for (uint64_t slot = home_slot(key, capacity); ; slot = next_slot(slot, capacity)) {
+    StoreEntry& e = entries[slot];
+    std::atomic_ref<uint64_t> state{e.key[1]};
+    uint64_t current = 0;
+    if (state.compare_exchange_strong(current, SLOT_BUSY, std::memory_order_acq_rel)) {
+      e.key[0] = entry.key[0];
+      e.solution[0] = entry.solution[0];
+      e.solution[1] = entry.solution[1];
+      state.store(entry.key[1], std::memory_order_release);
+      return;
+    }
+  }
+}
+
+// A table being built, in a file mapped read-write.
+struct TableFile {
+  std::string path;
+  void* mapping = nullptr;
+  size_t length = 0;
+  uint64_t capacity = 0;
+};
+
+// Creates an empty table file with the given capacity.
+bool create_table(const std::string& path, const uint64_t capacity, TableFile* table) {
+  const size_t length = sizeof(StoreHeader) + capacity * sizeof(StoreEntry);
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::cerr << "ERROR: cannot create store file: " << path << std::endl;
+    return false;
+  }
+  if (ftruncate(fd, length) != 0) {
+    std::cerr << "ERROR: cannot resize store file: " << path << std::endl;
+    close(fd);
+    unlink(path.c_str());
+    return false;
+  }
+  void* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "ERROR: cannot map store file: " << path << std::endl;
+    unlink(path.c_str());
+    return false;
+  }
+  *table = TableFile{path, mapping, length, capacity};
+  return true;
+}
+
+// Unmaps a table file, and removes it.
+void discard_table(TableFile& table) {
+  munmap(table.mapping, table.length);
+  unlink(table.path.c_str());
+  table.mapping = nullptr;
+}
+
+// Moves every entry of `table` into a new file with the given
+// capacity, using `threads` threads, and puts it in its place. On
+// failure, `table` is left for discard_table().
+bool resize_table(TableFile& table, const uint64_t capacity, const int threads) {
+  TableFile grown;
+  if (!create_table(table.path + ".resize", capacity, &grown))
+    return false;
+  const StoreEntry* from = entries_of(table.mapping);
+  StoreEntry* to = entries_of(grown.mapping);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      const uint64_t begin = table.capacity * i / threads;
+      const uint64_t end = table.capacity * (i + 1) / threads;
+      for (uint64_t slot = begin; slot < end; ++slot) {
+        if (from[slot].key[1] != 0)
+          move_entry(to, capacity, from[slot]);
+      }
+    });
+  }
+  for (std::thread& t : workers)
+    t.join();
+
+  if (rename(grown.path.c_str(), table.path.c_str()) != 0) {
+    std::cerr << "ERROR: cannot write store file: " << table.path << std::endl;
+    discard_table(grown);
+    return false;
+  }
+  munmap(table.mapping, table.length);
+  grown.path = table.path;
+  table = grown;
+  return true;
+}
+
+// Walks all the boards of a given size whose first row is claimed by
+// this worker, keeping only the lexicographically smallest board of
+// each symmetry class.
+class Enumerator {
+ public:
+  Enumerator(const int size, StoreEntry* entries, const uint64_t capacity,
+             std::atomic<uint64_t>& entry_count, std::atomic<uint64_t>& board_count)
+    : size_(size), entries_(entries), capacity_(capacity),
+      entry_count_(entry_count), board_count_(board_count) {}
+
+  // Enumerates all boards starting with the given first row.
+  void run(const int* first_row) {
+    std::fill(row_used_, row_used_ + size_, 0);
+    std::fill(column_used_, column_used_ + size_, 0);
+    for (int column = 0; column < size_; ++column)
+      place(0, column, first_row[column]);
+    search(size_);
+  }
+
+ private:
+  void place(const int row, const int column, const int value) {
+    cells_[row * size_ + column] = value;
+    row_used_[row] |= 1 << value;
+    column_used_[column] |= 1 << value;
+  }
+
+  void unplace(const int row, const int column, const int value) {
+    row_used_[row] &= ~(1 << value);
+    column_used_[column] &= ~(1 << value);
+  }
+
+  // Cheap necessary conditions for the board to be the smallest of
+  // its symmetry class, checked as soon as the cells are known.
+  bool may_be_canonical(const int row, const int column, const int value) const {
+    const int last = size_ - 1;
+    if (column == 0 && row == last && value < cells_[0])
+      // Mirroring top-bottom would give a smaller board.
+      return false;
+    if (row == last && column == last && value < cells_[0])
+      // Rotating by 180 degrees would give a smaller board.
+      return false;
+    if (column == 0 && row > 0) {
+      // Transposing compares the first row with the first column.
+      bool equal_so_far = true;
+      for (int i = 1; i < row && equal_so_far; ++i)
+        equal_so_far = cells_[i] == cells_[i * size_];
+      if (equal_so_far && value < cells_[row])
+        return false;
+    }
+    return true;
+  }
+
+  void search(const int cell) {
+    if (cell == size_ * size_) {
+      record();
+      return;
+    }
+    const int row = cell / size_;
+    const int column = cell % size_;
+    const int used = row_used_[row] | column_used_[column];
+    for (int value = 1; value <= size_; ++value) {
+      if ((used & (1 << value)) || !may_be_canonical(row, column, value))
+        continue;
+      place(row, column, value);
+      search(cell + 1);
+      unplace(row, column, value);
+    }
+  }
+
+  void record() {
+    const int cells = size_ * size_;
+    int images[SYMMETRIES][MAX_STORE_SIZE * MAX_STORE_SIZE];
+    for (int t = 0; t < SYMMETRIES; ++t) {
+      transform_cells(t, size_, cells_, images[t]);
+      if (std::lexicographical_compare(images[t], images[t] + cells, images[0], images[0] + cells))
+        // Another board of this class is the canonical one.
+        return;
+    }
+
+    // Store every distinct image; symmetric boards have duplicates.
+    // The clues of the images are permutations of the ones of the
+    // canonical board.
+    int clues[4 * MAX_STORE_SIZE];
+    compute_clues(size_, cells_, clues);
+    for (int t = 0; t < SYMMETRIES; ++t) {
+      bool duplicate = false;
+      for (int u = 0; u < t && !duplicate; ++u)
+        duplicate = std::equal(images[t], images[t] + cells, images[u]);
+      if (duplicate)
+        continue;
+
+      int image_clues[4 * MAX_STORE_SIZE];
+      transform_clues(t, size_, clues, image_clues);
+      uint64_t key[2];
+      uint64_t solution[2];
+      pack(image_clues, 4 * size_, key);
+      pack(images[t], cells, solution);
+      insert(entries_, capacity_, key, solution, entry_count_);
+      board_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  const int size_;
+  StoreEntry* entries_;
+  const uint64_t capacity_;
+  std::atomic<uint64_t>& entry_count_;
+  std::atomic<uint64_t>& board_count_;
+
+  int cells_[MAX_STORE_SIZE * MAX_STORE_SIZE];
+  // Bit v is set if value v is used in the row or column.
+  int row_used_[MAX_STORE_SIZE];
+  int column_used_[MAX_STORE_SIZE];
+};
+
+}  // namespace
+
+SolutionStore::SolutionStore(void* mapping, const size_t length)
+  : mapping_(mapping), length_(length) {}
+
+SolutionStore::SolutionStore(SolutionStore&& other)
+  : mapping_(other.mapping_), length_(other.length_) {
+  other.mapping_ = nullptr;
+  other.length_ = 0;
+}
+
+SolutionStore::~SolutionStore() {
+  if (mapping_ != nullptr)
+    munmap(mapping_, length_);
+}
+
+std::optional<SolutionStore> SolutionStore::open(const char* path) {
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "ERROR: cannot open store file: " << path << std::endl;
+    return std::nullopt;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(StoreHeader)) {
+    std::cerr << "ERROR: not a store file: " << path << std::endl;
+    close(fd);
+    return std::nullopt;
+  }
+  void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    std::cerr << "ERROR: cannot map store file: " << path << std::endl;
+    return std::nullopt;
+  }
+
+  SolutionStore store{mapping, size_t(st.st_size)};
+  const StoreHeader* header = header_of(mapping);
+  // The entries must fit in the file; the division keeps a huge
+  // capacity from wrapping around.
+  if (memcmp(header->magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 ||
+      header->version != STORE_VERSION || header->size < 1 || header->size > MAX_STORE_SIZE ||
+      header->capacity < 1 ||
+      header->capacity > (store.length_ - sizeof(StoreHeader)) / sizeof(StoreEntry)) {
+    std::cerr << "ERROR: not a valid store file: " << path << std::endl;
+    return std::nullopt;
+  }
+  return store;
+}
+
+int SolutionStore::size() const {
+  return header_of(mapping_)->size;
+}
+
+std::optional<StoreAnswer> SolutionStore::lookup(const int* clues) const {
+  const int size = this->size();
+  uint64_t key[2];
+  pack(clues, 4 * size, key);
+
+  const uint64_t capacity = header_of(mapping_)->capacity;
+  const StoreEntry* entries = entries_of(mapping_);
+  // A table without empty slots would never end the probe, so visit
+  // each slot at most once.
+  uint64_t slot = home_slot(key, capacity);
+  for (uint64_t probes = 0; probes < capacity; ++probes, slot = next_slot(slot, capacity)) {
+    const StoreEntry& e = entries[slot];
+    if (e.key[1] == 0)
+      return std::nullopt;
+    if (e.key[0] == key[0] && (e.key[1] & ~SLOT_FLAGS) == key[1]) {
+      StoreAnswer answer;
+      answer.solution.resize(size * size);
+      unpack(e.solution, size * size, answer.solution.data());
+      answer.unique = (e.key[1] & SLOT_MULTIPLE) == 0;
+      return answer;
+    }
+  }
+  return std::nullopt;
+}
+
+bool build_solution_store(const int size, const char* path, const int threads) {
+  if (size < 1 || size > MAX_STORE_SIZE) {
+    std::cerr << "ERROR: can only enumerate boards up to size " << MAX_STORE_SIZE << std::endl;
+    return false;
+  }
+
+  // All the first rows, in lexicographic order. Mirroring left-right
+  // requires the first cell to be smaller than the last one.
+  std::vector<std::vector<int>> first_rows;
+  std::vector<int> row(size);
+  for (int i = 0; i < size; ++i)
+    row[i] = i + 1;
+  do {
+    if (size == 1 || row.front() < row.back())
+      first_rows.push_back(row);
+  } while (std::next_permutation(row.begin(), row.end()));
+
+  // Each first row is shared by the same number of boards, and each
+  // board enumerated from it stores at most SYMMETRIES entries. This
+  // bounds how much a batch of rows can add to the table, which grows
+  // between batches, so that it is sized by the number of distinct
+  // sets of clues rather than by the number of boards.
+  uint64_t row_boards = LATIN_SQUARES[size];
+  for (int i = 2; i <= size; ++i)
+    row_boards /= i;
+  const uint64_t entries_per_row = SYMMETRIES * row_boards;
+
+  // Build into a temporary file, and only rename it when complete.
+  TableFile table;
+  const uint64_t initial = std::max<uint64_t>(2, threads * entries_per_row / MAX_LOAD);
+  if (!create_table(std::string(path) + ".tmp", initial, &table))
+    return false;
+
+  std::atomic<uint64_t> entry_count{0};
+  std::atomic<uint64_t> board_count{0};
+  std::atomic<size_t> next_row{0};
+  size_t batch_begin = 0;
+  while (batch_begin < first_rows.size()) {
+    const double limit = table.capacity * MAX_LOAD;
+    const uint64_t used = entry_count.load();
+    const size_t batch_rows = used < limit ? size_t((limit - used) / entries_per_row) : 0;
+    if (batch_rows < size_t(threads) && batch_begin + batch_rows < first_rows.size()) {
+      const uint64_t needed = (entry_count.load() + threads * entries_per_row) / MAX_LOAD;
+      if (!resize_table(table, std::max<uint64_t>(table.capacity * GROWTH, needed), threads)) {
+        discard_table(table);
+        return false;
+      }
+      continue;
+    }
+    const size_t batch_end = std::min(first_rows.size(), batch_begin + batch_rows);
+    StoreEntry* entries = entries_of(table.mapping);
+    const uint64_t capacity = table.capacity;
+    next_row.store(batch_begin);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back([&] {
+        Enumerator enumerator{size, entries, capacity, entry_count, board_count};
+        for (size_t r = next_row.fetch_add(1); r < batch_end; r = next_row.fetch_add(1))
+          enumerator.run(first_rows[r].data());
+      });
+    }
+    for (std::thread& t : workers)
+      t.join();
+    batch_begin = batch_end;
+  }
+
+  if (board_count.load() != LATIN_SQUARES[size]) {
+    std::cerr << "FATAL: enumerated " << board_count.load() << " boards instead of "
+              << LATIN_SQUARES[size] << ". This should never happen." << std::endl;
+    discard_table(table);
+    return false;
+  }
+
+  // The headroom kept for each batch can leave the table much
+  // emptier than needed; shrink it to fit.
+  const uint64_t fitted = std::max<uint64_t>(1, entry_count.load() / MAX_LOAD + 1);
+  if (table.capacity > fitted * GROWTH && !resize_table(table, fitted, threads)) {
+    discard_table(table);
+    return false;
+  }
+
+  StoreHeader* header = header_of(table.mapping);
+  memcpy(header->magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+  header->version = STORE_VERSION;
+  header->size = size;
+  header->capacity = table.capacity;
+  header->entries = entry_count.load();
+
+  if (msync(table.mapping, table.length, MS_SYNC) != 0 ||
+      rename(table.path.c_str(), path) != 0) {
+    std::cerr << "ERROR: cannot write store file: " << path << std::endl;
+    discard_table(table);
+    return false;
+  }
+  munmap(table.mapping, table.length);
+
+  std::cerr << "Enumerated " << board_count.load() << " boards with "
+            << entry_count.load() << " distinct sets of clues" << std::endl;
+  return true;
+}
+
+int run_enumeration(const ProgramOptions& options) {
+  if (options.store_options.store_file == nullptr) {
+    std::cerr << "ERROR: no store file given (-S/--store)" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int threads = resolve_thread_count(options.create_options.pipeline.generator_threads);
+  return build_solution_store(options.board_size, options.store_options.store_file, threads) ?
+    EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int run_lookup(const ProgramOptions& options) {
+  const int size = options.board_size;
+  std::vector<int> clues;
+  if (!parse_clues(options.store_options.clues, size, &clues)) {
+    std::cerr << "ERROR: expected " << 4 * size << " comma-separated clues between 0 and "
+              << size << ", got: " << options.store_options.clues << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::optional<StoreAnswer> answer;
+  const bool all_clues = std::find(clues.begin(), clues.end(), 0) == clues.end();
+  const std::optional<SolutionStore> store = options.store_options.store_file == nullptr ?
+    std::nullopt : SolutionStore::open(options.store_options.store_file);
+  if (store.has_value() && store->size() == size && all_clues) {
+    answer = store->lookup(clues.data());
+  } else {
+    // The store only covers full sets of clues of its own size.
+    std::cerr << "Not covered by a store, solving the puzzle" << std::endl;
+    const Puzzle puzzle{size, clues.data()};
+    SolverStats stats;
+    const std::optional<Board> b = [&] {
+      if (options.create_options.portfolio) {
+        PortfolioOptions portfolio_options;
+        portfolio_options.max_solutions = 2;
+        PortfolioStats portfolio_stats;
+        std::optional<Board> result = solve_portfolio(puzzle, portfolio_options, nullptr, &stats,
+                                                      &portfolio_stats);
+        portfolio_stats.print(std::cerr, portfolio_options);
+        return result;
+      }
+      SolverOptions solver_options;
+      solver_options.max_solutions = 2;
+      solver_options.backend = options.solver_backend;
+      return solve_puzzle(puzzle, solver_options, nullptr, &stats);
+    }();
+    if (b.has_value()) {
+      answer = StoreAnswer{};
+      for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column)
+          answer->solution.push_back(b->at(row, column));
+      }
+      answer->unique = stats.solutions == 1;
+    }
+  }
+
+  std::ofstream out{options.puzzle_output_file, std::ios::out};
+  if (!answer.has_value()) {
+    out << "No solution" << std::endl;
+    return EXIT_FAILURE;
+  }
+  out << (answer->unique ? "Unique solution" : "Multiple solutions, one of them is") << ":"
+      << std::endl;
+  Board b{size};
+  for (int i = 0; i < size * size; ++i)
+    b.set(answer->solution[i], i / size, i % size);
+  b.print(out);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOLUTION_STORE_H
+#define SOLUTION_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "options.h"
+
+// The largest board size that can be enumerated into a store. Both
+// the clues and the solution of a board must fit in 128 bits.
+constexpr int MAX_STORE_SIZE = 6;
+
+// What the store knows about a full set of clues.
+struct StoreAnswer {
+  // One of the boards with these clues, in row-major order.
+  std::vector<int> solution;
+  // Whether that board is the only one with these clues.
+  bool unique;
+};
+
+// A memory-mapped hash table that maps the full clues of every board
+// of a given size to one of its solutions. Lookups take a single hash
+// probe, instead of a search.
+class SolutionStore {
+ public:
+  // Maps an existing store file. Returns nothing if the file cannot be
+  // read or is not a store.
+  static std::optional<SolutionStore> open(const char* path);
+
+  SolutionStore(SolutionStore&& other);
+  SolutionStore& operator=(SolutionStore&&) = delete;
+  ~SolutionStore();
+
+  // The board size this store covers.
+  int size() const;
+
+  // Looks up 4 * size() clues, laid out as in `Puzzle::clues()`.
+  // Every clue must be given. Returns nothing if no board has these
+  // clues.
+  std::optional<StoreAnswer> lookup(const int* clues) const;
+
+ private:
+  SolutionStore(void* mapping, size_t length);
+
+  void* mapping_;
+  size_t length_;
+};
+
+// Enumerates every board of the given size, computes its clues and
+// writes a store to `path`, using `threads` threads. Only one board
+// in each class of rotations and reflections is walked; the others
+// are derived from it. Returns false on failure.
+bool build_solution_store(const int size, const char* path, const int threads);
+
+// Entry points for the --enumerate and --lookup program modes. They
+// return a value compatible with 'man 3 exit'.
+int run_enumeration(const ProgramOptions& options);
+int run_lookup(const ProgramOptions& options);
+
+#endif
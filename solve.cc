@@ -0,0 +1,674 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "solve.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <random>
+
+#include "alloc_stats.h"
+#include "board.h"
+#include "cdcl.h"
+#include "puzzle.h"
+#include "trace.h"
+
+namespace {
+
+// Offsets of each array inside the workspace of a SolverState.
+struct Layout {
+  size_t masks;
+  size_t values;
+  size_t clues;
+  size_t trail;
+  size_t queue;
+  size_t dirty;
+  size_t rules;
+  size_t steps;
+  size_t total;
+};
+
+constexpr size_t WORKSPACE_ALIGNMENT = 16;
+
+size_t align_up(const size_t n) {
+  return (n + WORKSPACE_ALIGNMENT - 1) & ~(WORKSPACE_ALIGNMENT - 1);
+}
+
+template <typename T>
+Layout compute_layout(const int size) {
+  const size_t cells = size_t(size) * size;
+  Layout l;
+  l.masks = 0;
+  l.values = align_up(l.masks + cells * sizeof(CandidateMask));
+  l.clues = align_up(l.values + cells * sizeof(uint8_t));
+  l.trail = align_up(l.clues + 4 * size * sizeof(int32_t));
+  // Along any search path, each cell loses candidates at most `size`
+  // times, so this bounds the live part of the trail.
+  l.queue = align_up(l.trail + cells * size * sizeof(T));
+  l.dirty = align_up(l.queue + cells * sizeof(int32_t));
+  l.rules = align_up(l.dirty + 2 * size * sizeof(uint8_t));
+  l.steps = align_up(l.rules + cells * sizeof(uint8_t));
+  l.total = align_up(l.steps + cells * sizeof(uint32_t));
+  return l;
+}
+
+// Returns a mask with the values 1 through `n` set.
+CandidateMask low_values(const int n) {
+  return n >= 64 ? ~CandidateMask(0) : (CandidateMask(1) << n) - 1;
+}
+
+int lowest_value(const CandidateMask mask) {
+  return std::countr_zero(mask) + 1;
+}
+
+// How many partial arrangements a line filter may explore before
+// giving up. This keeps the filter cheap on lines that are still
+// mostly open, where it would not prune much anyway.
+constexpr long LINE_FILTER_BUDGET = 1L << 14;
+
+// Enumerates the arrangements of a line that are compatible with the
+// candidates of its cells and with the clues at both ends, and
+// records which values appear in at least one of them.
+//
+// Buildings are placed from the tallest down: a building is then
+// visible from an end exactly when it lands closer to that end than
+// all the buildings placed so far, which gives exact counts at every
+// step.
+struct LineFilter {
+  int size;
+  int front_clue;
+  int back_clue;
+  const CandidateMask* masks;
+  // Positions (as a bitmask) where each value is still a candidate.
+  uint64_t positions[MAX_SOLVER_SIZE + 1];
+  int order[MAX_SOLVER_SIZE];
+  CandidateMask support[MAX_SOLVER_SIZE];
+  // Cells whose support does not cover all of their candidates yet.
+  int unsaturated;
+  long budget;
+  bool found;
+
+  // Returns false if the search was cut short, either because it ran
+  // out of budget or because nothing could be pruned anymore.
+  bool search(const int value, const uint64_t occupied, const int front_most,
+              const int back_most, const int front_visible, const int back_visible) {
+    if (--budget < 0)
+      return false;
+
+    if (value == 0) {
+      found = true;
+      for (int i = 0; i < size; ++i) {
+        const CandidateMask bit = CandidateMask(1) << (order[i] - 1);
+        if ((support[i] & bit) == 0) {
+          support[i] |= bit;
+          if (support[i] == masks[i])
+            --unsaturated;
+        }
+      }
+      return unsaturated > 0;
+    }
+
+    uint64_t options = positions[value] & ~occupied;
+    while (options != 0) {
+      const int position = std::countr_zero(options);
+      options &= options - 1;
+
+      // Each further visible building must land closer to the end
+      // than all the ones placed so far.
+      const int next_front_most = std::min(front_most, position);
+      const int next_back_most = std::max(back_most, position);
+      const int next_front_visible = front_visible + (position < front_most ? 1 : 0);
+      const int next_back_visible = back_visible + (position > back_most ? 1 : 0);
+      if (front_clue != 0 &&
+          (next_front_visible > front_clue || next_front_visible + next_front_most < front_clue))
+        continue;
+      if (back_clue != 0 &&
+          (next_back_visible > back_clue ||
+           next_back_visible + (size - 1 - next_back_most) < back_clue))
+        continue;
+
+      order[position] = value;
+      if (!search(value - 1, occupied | (uint64_t(1) << position), next_front_most,
+                  next_back_most, next_front_visible, next_back_visible))
+        return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace
+
+const char* rule_name(const DeductionRule rule) {
+  switch (rule) {
+  case DeductionRule::ASSIGNED:
+    return "assigned";
+  case DeductionRule::NAKED_SINGLE:
+    return "naked single";
+  case DeductionRule::HIDDEN_SINGLE:
+    return "hidden single";
+  case DeductionRule::CLUE_BOUNDS:
+    return "clue bounds";
+  case DeductionRule::VISIBILITY:
+    return "visibility";
+  case DeductionRule::LINE_ARRANGEMENT:
+    return "line arrangement";
+  }
+  return "unknown";
+}
+
+size_t SolverState::workspace_size(const int size) {
+  if (size <= 0 || size > MAX_SOLVER_SIZE)
+    return 0;
+  return compute_layout<TrailEntry>(size).total;
+}
+
+SolverState::SolverState(const int size, const int* clues, void* workspace, const size_t workspace_len)
+  : size_(size) {
+  if (size_ <= 0 || size_ > MAX_SOLVER_SIZE || workspace == nullptr ||
+      workspace_len < workspace_size(size_) ||
+      reinterpret_cast<uintptr_t>(workspace) % alignof(CandidateMask) != 0) {
+    return;
+  }
+  for (int i = 0; i < 4 * size_; ++i) {
+    if (clues[i] < 0 || clues[i] > size_)
+      return;
+  }
+
+  const Layout l = compute_layout<TrailEntry>(size_);
+  char* base = static_cast<char*>(workspace);
+  masks_ = reinterpret_cast<CandidateMask*>(base + l.masks);
+  values_ = reinterpret_cast<uint8_t*>(base + l.values);
+  clues_ = reinterpret_cast<int32_t*>(base + l.clues);
+  trail_ = reinterpret_cast<TrailEntry*>(base + l.trail);
+  queue_ = reinterpret_cast<int32_t*>(base + l.queue);
+  dirty_ = reinterpret_cast<uint8_t*>(base + l.dirty);
+  rules_ = reinterpret_cast<uint8_t*>(base + l.rules);
+  steps_ = reinterpret_cast<uint32_t*>(base + l.steps);
+
+  full_mask_ = low_values(size_);
+  const int cells = size_ * size_;
+  std::fill(masks_, masks_ + cells, full_mask_);
+  std::fill(values_, values_ + cells, 0);
+  std::copy(clues, clues + 4 * size_, clues_);
+  std::fill(dirty_, dirty_ + 2 * size_, 0);
+  ok_ = true;
+}
+
+bool SolverState::initialize() {
+  // A line seen from a clue `k` has its tallest building at distance
+  // `k - 1` or more, and more generally a value at distance `d` can
+  // be at most `size - k + 1 + d`.
+  for (int side = 0; side < 4; ++side) {
+    for (int line = 0; line < size_; ++line) {
+      const int k = clues_[side * size_ + line];
+      if (k == 0)
+        continue;
+      for (int d = 0; d < k - 1; ++d) {
+        int cell;
+        switch (side) {
+        case 0: cell = d * size_ + line; break;                  // top
+        case 1: cell = (size_ - 1 - d) * size_ + line; break;    // bottom
+        case 2: cell = line * size_ + d; break;                  // left
+        default: cell = line * size_ + (size_ - 1 - d); break;   // right
+        }
+        const int max_value = size_ - k + 1 + d;
+        rule_ = DeductionRule::CLUE_BOUNDS;
+        const bool ok = remove(cell, full_mask_ & ~low_values(max_value));
+        rule_ = DeductionRule::NAKED_SINGLE;
+        if (!ok) {
+          clear_pending();
+          return false;
+        }
+      }
+    }
+  }
+
+  // Check every line at least once.
+  std::fill(dirty_, dirty_ + 2 * size_, 1);
+  any_dirty_ = true;
+  return propagate();
+}
+
+bool SolverState::assign(const int cell, const int value) {
+  return assign_by(cell, value, DeductionRule::ASSIGNED);
+}
+
+bool SolverState::assign_by(const int cell, const int value, const DeductionRule rule) {
+  const CandidateMask bit = CandidateMask(1) << (value - 1);
+  if ((masks_[cell] & bit) == 0)
+    return false;
+  if (values_[cell] == value)
+    return true;
+
+  trail_[trail_size_++] = TrailEntry{masks_[cell], cell, values_[cell]};
+  masks_[cell] = bit;
+  values_[cell] = value;
+  rules_[cell] = uint8_t(rule);
+  steps_[cell] = trail_size_;
+  queue_[queue_tail_++] = cell;
+  mark_dirty(cell);
+  return true;
+}
+
+bool SolverState::remove(const int cell, const CandidateMask mask) {
+  CandidateMask m = masks_[cell];
+  if ((m & mask) == 0)
+    return true;
+
+  trail_[trail_size_++] = TrailEntry{m, cell, values_[cell]};
+  m &= ~mask;
+  masks_[cell] = m;
+  if (m == 0)
+    return false;
+
+  mark_dirty(cell);
+  if (values_[cell] == 0 && std::has_single_bit(m)) {
+    // Naked single: only one candidate is left.
+    values_[cell] = lowest_value(m);
+    rules_[cell] = uint8_t(rule_);
+    steps_[cell] = trail_size_;
+    queue_[queue_tail_++] = cell;
+  }
+  return true;
+}
+
+bool SolverState::propagate() {
+  while (true) {
+    // Remove the value of each newly assigned cell from its row and column.
+    while (queue_head_ < queue_tail_) {
+      const int cell = queue_[queue_head_++];
+      const CandidateMask bit = masks_[cell];
+      const int row = cell / size_;
+      const int column = cell % size_;
+      for (int i = 0; i < size_; ++i) {
+        if ((i != column && !remove(row * size_ + i, bit)) ||
+            (i != row && !remove(i * size_ + column, bit))) {
+          clear_pending();
+          return false;
+        }
+      }
+    }
+
+    if (!any_dirty_)
+      break;
+
+    // Run the line-based rules on every line that changed.
+    any_dirty_ = false;
+    ++rounds_;
+    for (int line = 0; line < 2 * size_; ++line) {
+      if (!dirty_[line])
+        continue;
+      dirty_[line] = 0;
+      const bool ok = check_hidden_singles(line) && check_visibility(line);
+      rule_ = DeductionRule::NAKED_SINGLE;
+      if (!ok) {
+        clear_pending();
+        return false;
+      }
+    }
+  }
+
+  clear_pending();
+  return true;
+}
+
+void SolverState::set_max_rule(const DeductionRule rule) {
+  if (rule > max_rule_) {
+    std::fill(dirty_, dirty_ + 2 * size_, 1);
+    any_dirty_ = true;
+  }
+  max_rule_ = rule;
+}
+
+void SolverState::undo(const size_t mark) {
+  while (trail_size_ > mark) {
+    const TrailEntry& e = trail_[--trail_size_];
+    masks_[e.cell] = e.mask;
+    values_[e.cell] = e.value;
+  }
+  clear_pending();
+}
+
+bool SolverState::complete() const {
+  const int cells = size_ * size_;
+  for (int cell = 0; cell < cells; ++cell) {
+    if (values_[cell] == 0)
+      return false;
+  }
+  return true;
+}
+
+void SolverState::mark_dirty(const int cell) {
+  dirty_[cell / size_] = 1;
+  dirty_[size_ + cell % size_] = 1;
+  any_dirty_ = true;
+}
+
+void SolverState::clear_pending() {
+  queue_head_ = queue_tail_ = 0;
+  if (any_dirty_) {
+    std::fill(dirty_, dirty_ + 2 * size_, 0);
+    any_dirty_ = false;
+  }
+}
+
+bool SolverState::check_hidden_singles(const int line) {
+  const int first = line < size_ ? line * size_ : line - size_;
+  const int stride = line < size_ ? 1 : size_;
+
+  // Collect the values that appear in at least one and in at least
+  // two cells of the line.
+  CandidateMask once = 0;
+  CandidateMask twice = 0;
+  for (int i = 0; i < size_; ++i) {
+    const CandidateMask m = masks_[first + i * stride];
+    twice |= once & m;
+    once |= m;
+  }
+  if (once != full_mask_)
+    // Some value cannot be placed anywhere in this line.
+    return false;
+
+  CandidateMask singles = once & ~twice;
+  while (singles != 0) {
+    const CandidateMask bit = singles & -singles;
+    singles ^= bit;
+    int i = 0;
+    while (i < size_ && (masks_[first + i * stride] & bit) == 0)
+      ++i;
+    if (i == size_)
+      // The cell holding the value was assigned something else.
+      return false;
+    if (values_[first + i * stride] == 0 &&
+        !assign_by(first + i * stride, lowest_value(bit), DeductionRule::HIDDEN_SINGLE))
+      return false;
+  }
+  return true;
+}
+
+bool SolverState::check_visibility(const int line) {
+  const int last = size_ - 1;
+  rule_ = DeductionRule::VISIBILITY;
+  if (line < size_) {
+    const int row = line;
+    return check_visibility_from(clues_[2 * size_ + row], row * size_, 1) &&
+      check_visibility_from(clues_[3 * size_ + row], row * size_ + last, -1) &&
+      filter_line(line);
+  }
+  const int column = line - size_;
+  return check_visibility_from(clues_[column], column, size_) &&
+    check_visibility_from(clues_[size_ + column], last * size_ + column, -size_) &&
+    filter_line(line);
+}
+
+bool SolverState::filter_line(const int line) {
+  if (max_rule_ < DeductionRule::LINE_ARRANGEMENT)
+    return true;
+  const bool is_row = line < size_;
+  const int first = is_row ? line * size_ : line - size_;
+  const int stride = is_row ? 1 : size_;
+
+  LineFilter filter;
+  filter.size = size_;
+  filter.front_clue = clues_[is_row ? 2 * size_ + line : line - size_];
+  filter.back_clue = clues_[is_row ? 3 * size_ + line : line];
+  if (filter.front_clue == 0 && filter.back_clue == 0)
+    return true;
+
+  CandidateMask masks[MAX_SOLVER_SIZE];
+  filter.unsaturated = 0;
+  for (int i = 0; i < size_; ++i) {
+    masks[i] = masks_[first + i * stride];
+    filter.support[i] = 0;
+    if (!std::has_single_bit(masks[i]))
+      ++filter.unsaturated;
+  }
+  if (filter.unsaturated == 0)
+    // The line is fully assigned, and check_visibility_from() has
+    // already verified it.
+    return true;
+  // Assigned cells are always supported by any arrangement found.
+  for (int i = 0; i < size_; ++i) {
+    if (std::has_single_bit(masks[i]))
+      filter.support[i] = masks[i];
+  }
+  for (int value = 1; value <= size_; ++value) {
+    const CandidateMask bit = CandidateMask(1) << (value - 1);
+    filter.positions[value] = 0;
+    for (int i = 0; i < size_; ++i) {
+      if (masks[i] & bit)
+        filter.positions[value] |= uint64_t(1) << i;
+    }
+  }
+  filter.masks = masks;
+  filter.budget = LINE_FILTER_BUDGET;
+  filter.found = false;
+
+  if (!filter.search(size_, 0, size_, -1, 0, 0))
+    // Out of budget, or nothing left to prune.
+    return true;
+  if (!filter.found)
+    return false;
+
+  rule_ = DeductionRule::LINE_ARRANGEMENT;
+  for (int i = 0; i < size_; ++i) {
+    if (!remove(first + i * stride, masks[i] & ~filter.support[i]))
+      return false;
+  }
+  return true;
+}
+
+bool SolverState::check_visibility_from(const int clue, const int first, const int stride) {
+  if (clue == 0)
+    return true;
+
+  // Count the visible buildings in the assigned prefix of the line.
+  int visible = 0;
+  int highest = 0;
+  int position = 0;
+  for (; position < size_; ++position) {
+    const int value = values_[first + position * stride];
+    if (value == 0)
+      break;
+    if (value > highest) {
+      highest = value;
+      ++visible;
+    }
+  }
+  if (position == size_)
+    return visible == clue;
+
+  // The tallest building is always visible, and each of the remaining
+  // cells can add at most one visible building.
+  const int lower = visible + (highest < size_ ? 1 : 0);
+  const int upper = visible + std::min(size_ - position, size_ - highest);
+  if (clue < lower || clue > upper)
+    return false;
+
+  if (clue - visible == 1 && highest < size_ && max_rule_ >= DeductionRule::VISIBILITY) {
+    // Only the tallest building can still become visible, so the next
+    // cell is either hidden or the tallest one.
+    const CandidateMask between = low_values(size_ - 1) & ~low_values(highest);
+    return remove(first + position * stride, between);
+  }
+  return true;
+}
+
+namespace {
+
+// A branching point of the search.
+struct Decision {
+  size_t mark;
+  CandidateMask remaining;
+  int32_t cell;
+};
+
+int pick_cell(const SolverState& state, const VariableOrder order) {
+  const int size = state.size();
+  const int cells = size * size;
+  int best = -1;
+  int best_count = MAX_SOLVER_SIZE + 1;
+  int best_open = 2 * MAX_SOLVER_SIZE + 1;
+  for (int cell = 0; cell < cells; ++cell) {
+    if (state.value(cell) != 0)
+      continue;
+    if (order == VariableOrder::ROW_MAJOR)
+      return cell;
+    const int count = std::popcount(state.candidates(cell));
+    if (count > best_count)
+      continue;
+    // Break ties towards the cells whose lines are the least open.
+    int open = 0;
+    const int row = cell / size;
+    const int column = cell % size;
+    for (int i = 0; i < size; ++i)
+      open += (state.value(row * size + i) == 0) + (state.value(i * size + column) == 0);
+    if (count < best_count || open < best_open) {
+      best = cell;
+      best_count = count;
+      best_open = open;
+    }
+  }
+  return best;
+}
+
+int pick_value(const CandidateMask remaining, const ValueOrder order, std::mt19937& generator) {
+  switch (order) {
+  case ValueOrder::ASCENDING:
+    break;
+  case ValueOrder::DESCENDING:
+    return std::bit_width(remaining);
+  case ValueOrder::RANDOM: {
+    std::uniform_int_distribution<int> chooser{0, std::popcount(remaining) - 1};
+    CandidateMask m = remaining;
+    for (int skip = chooser(generator); skip > 0; --skip)
+      m &= m - 1;
+    return lowest_value(m);
+  }
+  }
+  return lowest_value(remaining);
+}
+
+}  // namespace
+
+size_t solve_workspace_size(const int size) {
+  const size_t state = SolverState::workspace_size(size);
+  if (state == 0)
+    return 0;
+  return state + align_up(size_t(size) * size * sizeof(Decision));
+}
+
+SolveStatus solve_clues(const int size, const int* clues, const SolverOptions& options,
+                        int* solution, void* workspace, const size_t workspace_len,
+                        SolverStats* stats) {
+  SolverStats local_stats;
+  if (stats == nullptr)
+    stats = &local_stats;
+  *stats = SolverStats{};
+
+  if (workspace_len < solve_workspace_size(size) || options.max_solutions < 1)
+    return SolveStatus::INVALID_INPUT;
+  const size_t state_len = SolverState::workspace_size(size);
+  SolverState state{size, clues, workspace, state_len};
+  if (!state.ok())
+    return SolveStatus::INVALID_INPUT;
+  Decision* decisions = reinterpret_cast<Decision*>(static_cast<char*>(workspace) + state_len);
+
+  if (!state.initialize())
+    return SolveStatus::NO_SOLUTION;
+
+  std::mt19937 generator{options.seed};
+  const int cells = size * size;
+  int depth = 0;
+  while (true) {
+    const int cell = pick_cell(state, options.variable_order);
+    if (cell >= 0) {
+      decisions[depth++] = Decision{state.checkpoint(), state.candidates(cell), cell};
+    } else {
+      // Every cell is assigned, and propagation verified all the clues.
+      if (stats->solutions++ == 0) {
+        for (int i = 0; i < cells; ++i)
+          solution[i] = state.value(i);
+      }
+      if (stats->solutions >= options.max_solutions)
+        return SolveStatus::SOLVED;
+    }
+
+    // Try the next candidate of the innermost decision, backtracking
+    // out of the exhausted ones.
+    bool advanced = false;
+    while (depth > 0 && !advanced) {
+      Decision& d = decisions[depth - 1];
+      state.undo(d.mark);
+      if (d.remaining == 0) {
+        --depth;
+        continue;
+      }
+      if (stop_requested(options))
+        return SolveStatus::CANCELLED;
+      if (options.max_nodes > 0 && stats->nodes >= options.max_nodes)
+        return SolveStatus::CANCELLED;
+
+      const int value = pick_value(d.remaining, options.value_order, generator);
+      d.remaining &= ~(CandidateMask(1) << (value - 1));
+      ++stats->nodes;
+      advanced = state.assign(d.cell, value) && state.propagate();
+      if (!advanced)
+        ++stats->backtracks;
+    }
+    if (!advanced)
+      return stats->solutions > 0 ? SolveStatus::SOLVED : SolveStatus::NO_SOLUTION;
+  }
+}
+
+SolverBackend pick_backend(const SolverBackend backend, const int size) {
+  if (backend != SolverBackend::AUTO)
+    return backend;
+  if (size <= MAX_SEARCH_BACKEND_SIZE || size > MAX_CDCL_SIZE)
+    return SolverBackend::SEARCH;
+  return SolverBackend::CDCL;
+}
+
+std::optional<Board> solve_puzzle(const Puzzle& puzzle, const SolverOptions& options,
+                                  SolveStatus* status, SolverStats* stats) {
+  TraceScope trace{"solve"};
+  AllocPhaseScope alloc_phase{AllocPhase::SOLVING};
+  const int size = puzzle.size();
+  const std::vector<int> clues = puzzle.clues();
+  const size_t workspace_len = solve_workspace_size(size);
+  std::unique_ptr<CandidateMask[]> workspace{
+    new CandidateMask[workspace_len / sizeof(CandidateMask) + 1]};
+  std::vector<int> cells(size_t(size) * size);
+
+  const SolveStatus result = pick_backend(options.backend, size) == SolverBackend::CDCL ?
+    solve_clues_cdcl(size, clues.data(), options, cells.data(), stats) :
+    solve_clues(size, clues.data(), options, cells.data(), workspace.get(), workspace_len, stats);
+  if (status != nullptr)
+    *status = result;
+  if (result != SolveStatus::SOLVED)
+    return std::nullopt;
+
+  Board b{size};
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column)
+      b.set(cells[row * size + column], row, column);
+  }
+  return b;
+}
@@ -0,0 +1,258 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "board.h"
+#include "options.h"
+#include "puzzle.h"
+
+// Bitmask of the values that are still possible in a cell: bit (v - 1)
+// is set if value v is a candidate.
+using CandidateMask = uint64_t;
+
+// The largest board the solver accepts, bound by the width of
+// CandidateMask. The search only stays fast up to about
+// MAX_SEARCH_BACKEND_SIZE; past that, full-clue puzzles can take
+// minutes each, while the CDCL backend takes well under a second.
+constexpr int MAX_SOLVER_SIZE = 64;
+
+// The largest board SolverBackend::AUTO hands to the search.
+constexpr int MAX_SEARCH_BACKEND_SIZE = 8;
+
+// Defines how the search picks the next cell to branch on.
+enum class VariableOrder {
+  // The first unassigned cell, in row-major order.
+  ROW_MAJOR = 0,
+  // The unassigned cell with the fewest candidates.
+  MIN_CANDIDATES,
+};
+
+// Defines the order in which the search tries the candidates of a cell.
+enum class ValueOrder {
+  ASCENDING = 0,
+  DESCENDING,
+  // Uniformly random, driven by `SolverOptions::seed`.
+  RANDOM,
+};
+
+// Resolves SolverBackend::AUTO to the backend for puzzles of the
+// given size; returns the other backends unchanged.
+SolverBackend pick_backend(const SolverBackend backend, const int size);
+
+struct SolverOptions {
+  // Only `solve_puzzle()` honors this; `solve_clues()` always searches.
+  SolverBackend backend = SolverBackend::SEARCH;
+  VariableOrder variable_order = VariableOrder::MIN_CANDIDATES;
+  ValueOrder value_order = ValueOrder::ASCENDING;
+  uint32_t seed = 0;
+  // Stop after finding this many solutions. Use 2 to check whether a
+  // puzzle has a unique solution.
+  int max_solutions = 1;
+  // If not null, the search stops as soon as this becomes true.
+  const std::atomic<bool>* cancel = nullptr;
+  // Same as `cancel`, so that a search can be stopped both from outside
+  // and by its caller, such as a portfolio ending a race.
+  const std::atomic<bool>* stop = nullptr;
+  // If positive, the search stops after trying this many values.
+  long max_nodes = 0;
+};
+
+// Returns whether `cancel` or `stop` asks the search to stop.
+inline bool stop_requested(const SolverOptions& options) {
+  return (options.cancel != nullptr && options.cancel->load(std::memory_order_relaxed)) ||
+    (options.stop != nullptr && options.stop->load(std::memory_order_relaxed));
+}
+
+enum class SolveStatus {
+  // At least one solution was found.
+  SOLVED = 0,
+  // The search space was exhausted without finding any solution.
+  NO_SOLUTION,
+  // The search was stopped through `SolverOptions::cancel` or `stop`,
+  // or ran out of `SolverOptions::max_nodes`.
+  CANCELLED,
+  // The size, the clues or the workspace are not acceptable.
+  INVALID_INPUT,
+};
+
+// The rule that assigned a cell during propagation, from the simplest
+// to the most involved.
+enum class DeductionRule : uint8_t {
+  // Assigned from outside, through `assign()`.
+  ASSIGNED = 0,
+  // Only one candidate was left once the values assigned in the
+  // cell's row and column were removed.
+  NAKED_SINGLE,
+  // The value had no other place in the cell's row or column.
+  HIDDEN_SINGLE,
+  // The distance from a clue bounds the height of the cell.
+  CLUE_BOUNDS,
+  // The buildings already visible from a clue leave a single option.
+  VISIBILITY,
+  // No arrangement of the line that satisfies its clues puts any other
+  // value in the cell.
+  LINE_ARRANGEMENT,
+};
+
+// Returns a short human-readable description of a rule.
+const char* rule_name(const DeductionRule rule);
+
+struct SolverStats {
+  // Number of solutions found, up to `SolverOptions::max_solutions`.
+  int solutions = 0;
+  // Number of values tried by the search.
+  long nodes = 0;
+  // Number of values that led to a contradiction.
+  long backtracks = 0;
+};
+
+// Holds the candidates of every cell of a puzzle, and propagates the
+// consequences of each assignment. Every change is recorded on a
+// trail, so that any earlier state can be restored cheaply.
+//
+// The state lives entirely in a caller-provided workspace of at least
+// `workspace_size(size)` bytes, and never allocates.
+class SolverState {
+ public:
+  // Returns the number of workspace bytes needed for the given size.
+  static size_t workspace_size(const int size);
+
+  // Prepares the state for a puzzle of the given size, with 4 * size
+  // clues laid out as in `Puzzle::clues()`. Zero clues are ignored.
+  // The clues are copied into the workspace.
+  SolverState(const int size, const int* clues, void* workspace, const size_t workspace_len);
+
+  // Returns whether the size, clues and workspace were acceptable.
+  // No other method may be called otherwise.
+  bool ok() const { return ok_; }
+
+  int size() const { return size_; }
+
+  // Applies the constraints implied by the clues, and propagates
+  // them. Returns false if the puzzle is found to be contradictory.
+  bool initialize();
+
+  // Assigns `value` to a cell (in row-major order), and queues its
+  // consequences. Returns false if the value is not a candidate.
+  bool assign(const int cell, const int value);
+
+  // Removes the values in `mask` from the candidates of a cell.
+  // Returns false if this leaves the cell without candidates.
+  bool remove(const int cell, const CandidateMask mask);
+
+  // Propagates all queued consequences until a fixed point is
+  // reached. Returns false on contradiction; the state must then be
+  // restored with `undo()`.
+  bool propagate();
+
+  // Restricts the rules that propagation may use to those up to
+  // `rule`; the singles and the clue bounds are always used. Raising
+  // the limit schedules every line for another check.
+  void set_max_rule(const DeductionRule rule);
+
+  // Returns how many rounds of line checks propagation has run.
+  long rounds() const { return rounds_; }
+
+  // Returns a marker of the current state, suitable for `undo()`.
+  size_t checkpoint() const { return trail_size_; }
+
+  // Restores the state as it was when `checkpoint()` returned `mark`.
+  void undo(const size_t mark);
+
+  CandidateMask candidates(const int cell) const { return masks_[cell]; }
+
+  // Returns the value of a cell, or zero if it is not assigned yet.
+  int value(const int cell) const { return values_[cell]; }
+
+  // For an assigned cell, returns the rule that assigned it, and the
+  // position of the assignment on the trail: cells with smaller steps
+  // were assigned earlier.
+  DeductionRule rule(const int cell) const { return DeductionRule(rules_[cell]); }
+  uint32_t step(const int cell) const { return steps_[cell]; }
+
+  // Returns whether all cells are assigned.
+  bool complete() const;
+
+  // Returns the clue for the given line end, or zero.
+  int clue(const int index) const { return clues_[index]; }
+
+ private:
+  struct TrailEntry {
+    CandidateMask mask;
+    int32_t cell;
+    int32_t value;
+  };
+
+  bool assign_by(const int cell, const int value, const DeductionRule rule);
+  void mark_dirty(const int cell);
+  void clear_pending();
+  bool check_hidden_singles(const int line);
+  bool check_visibility(const int line);
+  bool check_visibility_from(const int clue, const int first, const int stride);
+  bool filter_line(const int line);
+
+  int size_ = 0;
+  bool ok_ = false;
+  CandidateMask full_mask_ = 0;
+
+  // These arrays live in the workspace.
+  CandidateMask* masks_ = nullptr;
+  uint8_t* values_ = nullptr;
+  int32_t* clues_ = nullptr;
+  TrailEntry* trail_ = nullptr;
+  int32_t* queue_ = nullptr;
+  // Lines (rows first, then columns) that changed since their last check.
+  uint8_t* dirty_ = nullptr;
+  uint8_t* rules_ = nullptr;
+  uint32_t* steps_ = nullptr;
+
+  size_t trail_size_ = 0;
+  int queue_head_ = 0;
+  int queue_tail_ = 0;
+  bool any_dirty_ = false;
+  // The rule credited for the naked singles that `remove()` finds.
+  DeductionRule rule_ = DeductionRule::NAKED_SINGLE;
+  DeductionRule max_rule_ = DeductionRule::LINE_ARRANGEMENT;
+  long rounds_ = 0;
+};
+
+// Returns the number of workspace bytes needed by `solve_clues()`.
+size_t solve_workspace_size(const int size);
+
+// Solves the puzzle with the given clues (see `SolverState`), writing
+// the first solution found to `solution` in row-major order. Does not
+// allocate: all the state lives in `workspace`.
+SolveStatus solve_clues(const int size, const int* clues, const SolverOptions& options,
+                        int* solution, void* workspace, const size_t workspace_len,
+                        SolverStats* stats);
+
+// Convenience wrapper around `solve_clues()`, or `solve_clues_cdcl()`
+// for the CDCL backend, for a Puzzle. Returns the first solution
+// found, if any.
+std::optional<Board> solve_puzzle(const Puzzle& puzzle, const SolverOptions& options,
+                                  SolveStatus* status = nullptr,
+                                  SolverStats* stats = nullptr);
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "symmetry.h"
+
+#include <vector>
+
+namespace {
+
+// A symmetry as a walk over the source cells: the transformed cell at
+// (row, column) comes from `origin + row * row_stride + column *
+// column_stride`, all in units of cells.
+struct Walk {
+  int origin;
+  int row_stride;
+  int column_stride;
+};
+
+Walk make_walk(const int symmetry, const int size) {
+  const int last = size - 1;
+  switch (symmetry) {
+  case 0: return {0, size, 1};                        // identity
+  case 1: return {0, 1, size};                        // transpose
+  case 2: return {last * size, 1, -size};             // rotate 90
+  case 3: return {last * size + last, -size, -1};     // rotate 180
+  case 4: return {last, -1, size};                    // rotate 270
+  case 5: return {last, size, -1};                    // mirror left-right
+  case 6: return {last * size, -size, 1};             // mirror top-bottom
+  default: return {last * size + last, -1, -size};    // anti-transpose
+  }
+}
+
+// Returns the clue for the source line through cell `index`, seen from
+// the side where walking by `stride` cells enters the board.
+int clue_towards(const int size, const int* clues, const int index, const int stride) {
+  if (stride == size)
+    return clues[index % size];                 // top, looking down
+  if (stride == -size)
+    return clues[size + index % size];          // bottom, looking up
+  if (stride == 1)
+    return clues[2 * size + index / size];      // left, looking right
+  return clues[3 * size + index / size];        // right, looking left
+}
+
+}  // namespace
+
+const char* symmetry_name(const int symmetry) {
+  switch (symmetry) {
+  case 0: return "identity";
+  case 1: return "transpose";
+  case 2: return "rotate-90";
+  case 3: return "rotate-180";
+  case 4: return "rotate-270";
+  case 5: return "mirror-left-right";
+  case 6: return "mirror-top-bottom";
+  default: return "anti-transpose";
+  }
+}
+
+int transformed_index(const int symmetry, const int size, const int row, const int column) {
+  const Walk walk = make_walk(symmetry, size);
+  return walk.origin + row * walk.row_stride + column * walk.column_stride;
+}
+
+void transform_cells(const int symmetry, const int size, const int* cells, int* out) {
+  const Walk walk = make_walk(symmetry, size);
+  const int* row_start = cells + walk.origin;
+  for (int row = 0; row < size; ++row, row_start += walk.row_stride) {
+    const int* cell = row_start;
+    for (int column = 0; column < size; ++column, cell += walk.column_stride)
+      *out++ = *cell;
+  }
+}
+
+void transform_clues(const int symmetry, const int size, const int* clues, int* out) {
+  const Walk walk = make_walk(symmetry, size);
+  int* top = out;
+  int* bottom = out + size;
+  int* left = out + 2 * size;
+  int* right = out + 3 * size;
+  // A line of the image is a line of the source, walked in the
+  // direction of one of the strides.
+  for (int column = 0; column < size; ++column) {
+    const int first = walk.origin + column * walk.column_stride;
+    top[column] = clue_towards(size, clues, first, walk.row_stride);
+    bottom[column] = clue_towards(size, clues, first, -walk.row_stride);
+  }
+  for (int row = 0; row < size; ++row) {
+    const int first = walk.origin + row * walk.row_stride;
+    left[row] = clue_towards(size, clues, first, walk.column_stride);
+    right[row] = clue_towards(size, clues, first, -walk.column_stride);
+  }
+}
+
+Board transform_board(const int symmetry, const Board& board) {
+  const int size = board.size();
+  std::vector<int> cells(size * size);
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column)
+      cells[row * size + column] = board.at(row, column);
+  }
+  std::vector<int> image(size * size);
+  transform_cells(symmetry, size, cells.data(), image.data());
+
+  Board result{size};
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column)
+      result.set(image[row * size + column], row, column);
+  }
+  return result;
+}
+
+Puzzle transform_puzzle(const int symmetry, const Puzzle& puzzle) {
+  const int size = puzzle.size();
+  const std::vector<int> clues = puzzle.clues();
+  std::vector<int> image(4 * size);
+  transform_clues(symmetry, size, clues.data(), image.data());
+  return Puzzle{size, image.data()};
+}
@@ -0,0 +1,50 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include "board.h"
+#include "puzzle.h"
+
+// The eight rotations and reflections of a square board, numbered
+// from 0 (identity) to 7. They map valid boards to valid boards, and
+// the clues of a board to the clues of its image.
+constexpr int SYMMETRIES = 8;
+
+// Returns a short name for a symmetry, such as "rotate-90".
+const char* symmetry_name(const int symmetry);
+
+// Returns the index, in a `size * size` row-major board, of the cell
+// that lands at `row` and `column` of the transformed board.
+int transformed_index(const int symmetry, const int size, const int row, const int column);
+
+// Writes the image of `size * size` row-major cells to `out`, by
+// walking the source with fixed strides.
+void transform_cells(const int symmetry, const int size, const int* cells, int* out);
+
+// Writes the clues of the transformed board to `out`, given the 4 *
+// size clues of the original one, laid out as in `Puzzle::clues()`.
+// This only permutes the clues: no visibility is recomputed.
+void transform_clues(const int symmetry, const int size, const int* clues, int* out);
+
+// Convenience wrappers of the above.
+Board transform_board(const int symmetry, const Board& board);
+Puzzle transform_puzzle(const int symmetry, const Puzzle& puzzle);
+
+#endif
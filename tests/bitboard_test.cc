@@ -0,0 +1,119 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <optional>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "bitboard.h"
+#include "board.h"
+#include "check.h"
+#include "puzzle.h"
+
+namespace {
+
+Board to_board(const int size, const std::vector<int>& cells) {
+  Board b{size};
+  for (int i = 0; i < size * size; ++i)
+    b.set(cells[i], i / size, i % size);
+  return b;
+}
+
+// Every cell, row and column agrees with the same `Board`.
+void check_same(const BitBoard& bits, const Board& b) {
+  const int size = b.size();
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column)
+      CHECK(bits.at(row, column) == b.at(row, column));
+  }
+  for (int i = 0; i < size; ++i) {
+    CHECK(bits.is_row_valid(i) == b.is_row_valid(i));
+    CHECK(bits.is_column_valid(i) == b.is_column_valid(i));
+  }
+  CHECK(bits.is_valid() == b.is_valid());
+}
+
+void check_size(const int size, std::mt19937& generator) {
+  std::uniform_int_distribution<int> line{0, size - 1};
+  std::uniform_int_distribution<int> value{1, size};
+  std::set<std::vector<int>> boards;
+  std::set<uint64_t> hashes;
+  for (int i = 0; i < 50; ++i) {
+    const std::vector<int> cells = random_cells(size, generator);
+    Board b = to_board(size, cells);
+    std::optional<BitBoard> bits = BitBoard::from_board(b);
+    CHECK(bits.has_value());
+    if (!bits.has_value())
+      return;
+    check_same(*bits, b);
+    Board copy{size};
+    bits->copy_to(copy);
+    CHECK(copy == b);
+
+    // The clues of a valid board.
+    std::vector<int> expected(4 * size);
+    compute_clues(size, cells.data(), expected.data());
+    std::vector<int> clues(4 * size);
+    bits->compute_clues(clues.data());
+    CHECK(clues == expected);
+
+    // Transposing twice gives the board back.
+    const BitBoard transposed = bits->transposed();
+    for (int row = 0; row < size; ++row) {
+      for (int column = 0; column < size; ++column)
+        CHECK(transposed.at(row, column) == b.at(column, row));
+    }
+    CHECK(transposed.transposed() == *bits);
+
+    // Equal boards hash the same; distinct ones, almost surely not.
+    CHECK(BitBoard::from_board(b)->hash() == bits->hash());
+    boards.insert(cells);
+    hashes.insert(bits->hash());
+
+    // Swaps keep agreeing with the board.
+    const int first = line(generator);
+    const int second = line(generator);
+    CHECK(bits->swap_rows(first, second) == b.swap_rows(first, second));
+    CHECK(bits->swap_columns(second, first) == b.swap_columns(second, first));
+    check_same(*bits, b);
+
+    // So do the validity checks once cells are changed or cleared.
+    const int row = line(generator);
+    const int column = line(generator);
+    const int v = value(generator);
+    CHECK(bits->set(v, row, column) == b.set(v, row, column));
+    check_same(*bits, b);
+    const int cleared = line(generator);
+    bits->clear(cleared, column);
+    b.clear(cleared, column);
+    check_same(*bits, b);
+  }
+  CHECK(hashes.size() == boards.size());
+  CHECK(!BitBoard::from_board(Board{MAX_BITBOARD_SIZE + 1}).has_value());
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  for (int size = 1; size <= MAX_BITBOARD_SIZE; ++size)
+    check_size(size, generator);
+  return check_result();
+}
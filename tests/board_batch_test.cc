@@ -0,0 +1,117 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "board_batch.h"
+#include "check.h"
+#include "puzzle.h"
+
+namespace {
+
+Board to_board(const int size, const std::vector<int>& cells) {
+  Board b{size};
+  for (int i = 0; i < size * size; ++i) {
+    if (cells[i] != 0)
+      b.set(cells[i], i / size, i % size);
+  }
+  return b;
+}
+
+// Returns the cells of a board for lane `lane`: valid boards, boards
+// with a repeated value in a row and a column, with two cells swapped
+// within a row, and with an empty cell.
+std::vector<int> lane_cells(const int size, const int lane, std::mt19937& generator) {
+  std::vector<int> cells = random_cells(size, generator);
+  if (size == 1)
+    return cells;
+  std::uniform_int_distribution<int> position{0, size - 1};
+  const int row = position(generator);
+  const int column = position(generator);
+  switch (lane % 4) {
+  case 1:
+    cells[row * size + column] = cells[row * size + (column + 1) % size];
+    break;
+  case 2:
+    std::swap(cells[row * size + column], cells[row * size + (column + 1) % size]);
+    break;
+  case 3:
+    cells[row * size + column] = 0;
+    break;
+  }
+  return cells;
+}
+
+// Fills `count` lanes of a batch, and checks the clues and validity of
+// every lane against compute_clues() and Board::is_valid(). The batch
+// is reused, so that stale lanes from the previous fill must not leak
+// into the results.
+void check_batch(BoardBatch& batch, const int count, std::mt19937& generator) {
+  const int size = batch.size();
+  batch.clear();
+  std::vector<std::vector<int>> lanes;
+  for (int lane = 0; lane < count; ++lane) {
+    lanes.push_back(lane_cells(size, lane, generator));
+    CHECK(batch.add(to_board(size, lanes.back())));
+  }
+  CHECK(batch.count() == count);
+
+  std::vector<uint8_t> clues(4 * size * count);
+  batch.compute_clues(clues.data());
+  bool valid[MAX_BATCH_CAPACITY];
+  batch.validate(valid);
+  std::vector<int> expected(4 * size);
+  for (int lane = 0; lane < count; ++lane) {
+    compute_clues(size, lanes[lane].data(), expected.data());
+    for (int i = 0; i < 4 * size; ++i)
+      CHECK(clues[i * count + lane] == expected[i]);
+    CHECK(valid[lane] == to_board(size, lanes[lane]).is_valid());
+    if (size > 1)
+      CHECK(valid[lane] == (lane % 4 == 0));
+  }
+}
+
+void check_size(const int size, std::mt19937& generator) {
+  for (const int capacity : {1, 7, MAX_BATCH_CAPACITY}) {
+    BoardBatch batch{size, capacity};
+    check_batch(batch, capacity, generator);
+    // A partial batch, after a full one.
+    check_batch(batch, (capacity + 1) / 2, generator);
+
+    // Full batches and boards of another size are refused.
+    CHECK(!batch.add(Board{size + 1}));
+    for (int lane = batch.count(); lane < capacity; ++lane)
+      CHECK(batch.add(Board{size, BoardInitializer::DIAGONAL_INCREASING}));
+    CHECK(!batch.add(Board{size, BoardInitializer::DIAGONAL_INCREASING}));
+    CHECK(batch.count() == capacity);
+  }
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  for (int size = 1; size <= MAX_BATCH_BOARD_SIZE; ++size)
+    check_size(size, generator);
+  return check_result();
+}
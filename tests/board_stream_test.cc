@@ -0,0 +1,76 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "board_stream.h"
+#include "check.h"
+#include "create_bulk.h"
+
+namespace {
+
+// A stream yields the boards of bulk creation with the same seed,
+// including once the seeds pass UINT32_MAX.
+void check_matches_bulk_creation(const CreateMode mode, const uint64_t seed) {
+  constexpr int COUNT = 6;
+  const std::string path = (std::filesystem::temp_directory_path() /
+                            "board_stream_test.txt").string();
+  ProgramOptions options;
+  options.mode = ProgramMode::CREATE;
+  options.board_size = 5;
+  options.board_output_file = path.c_str();
+  options.puzzle_output_file = "/dev/null";
+  options.create_options.mode = mode;
+  options.create_options.seed = seed;
+  options.create_options.count = COUNT;
+  options.create_options.pipeline = PipelineOptions{1, 1, 1};
+  CHECK(create_boards_in_bulk(options) == EXIT_SUCCESS);
+  std::ifstream in{path};
+  std::stringstream bulk;
+  bulk << in.rdbuf();
+  std::remove(path.c_str());
+
+  std::stringstream streamed;
+  BoardStream stream{mode, 5, seed};
+  for (const Board& b : stream) {
+    CHECK(b.is_valid());
+    CHECK(stream.seed() == seed + stream.created() - 1);
+    if (stream.created() > 1)
+      streamed << std::endl;
+    b.print(streamed);
+    if (stream.created() == COUNT)
+      break;
+  }
+  CHECK(streamed.str() == bulk.str());
+}
+
+}  // namespace
+
+int main() {
+  for (const CreateMode mode : {CreateMode::SHUFFLE, CreateMode::RANDOM, CreateMode::DLX}) {
+    check_matches_bulk_creation(mode, 1);
+    check_matches_bulk_creation(mode, UINT32_MAX - 2);
+  }
+  return check_result();
+}
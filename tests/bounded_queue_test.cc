@@ -0,0 +1,69 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "check.h"
+
+namespace {
+
+// Several producers and consumers move every value through a small
+// queue exactly once, blocking on both ends along the way.
+void check_every_value_arrives_once(const int producers, const int consumers) {
+  constexpr int PER_PRODUCER = 20000;
+  BoundedQueue<int> queue{4};
+  std::vector<std::atomic<int>> seen(producers * PER_PRODUCER);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, p] {
+      for (int i = 0; i < PER_PRODUCER; ++i)
+        queue.push(p * PER_PRODUCER + i + 1);
+    });
+  }
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&queue, &seen] {
+      // Zero marks the end of the stream.
+      while (const int value = queue.pop())
+        seen[value - 1].fetch_add(1);
+    });
+  }
+  for (int p = 0; p < producers; ++p)
+    threads[p].join();
+  for (int c = 0; c < consumers; ++c)
+    queue.push(0);
+  for (std::thread& t : threads) {
+    if (t.joinable())
+      t.join();
+  }
+  for (const std::atomic<int>& count : seen)
+    CHECK(count.load() == 1);
+}
+
+}  // namespace
+
+int main() {
+  check_every_value_arrives_once(1, 1);
+  check_every_value_arrives_once(4, 1);
+  check_every_value_arrives_once(1, 4);
+  check_every_value_arrives_once(4, 4);
+  return check_result();
+}
@@ -0,0 +1,100 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "check.h"
+#include "skyscraper.h"
+
+namespace {
+
+// Counts the heap allocations of the whole program.
+int allocations = 0;
+
+}  // namespace
+
+void* operator new(std::size_t n) {
+  ++allocations;
+  if (void* p = std::malloc(n == 0 ? 1 : n))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+// The workspace call creates the same boards as skyscraper_create(),
+// without allocating.
+void check_create_dlx() {
+  for (int size = 2; size <= 12; ++size) {
+    const size_t workspace_len = skyscraper_create_workspace_size(size);
+    CHECK(workspace_len > 0);
+    std::vector<uint64_t> workspace(workspace_len / sizeof(uint64_t) + 1);
+    std::vector<int> board(size * size);
+    std::vector<int> clues(4 * size);
+    std::vector<int> expected_board(size * size);
+    std::vector<int> expected_clues(4 * size);
+    for (uint32_t seed = 1; seed <= 20; ++seed) {
+      CHECK(skyscraper_create(SKYSCRAPER_CREATE_DLX, size, seed, expected_board.data(),
+                              expected_board.size(), expected_clues.data(),
+                              expected_clues.size()) == SKYSCRAPER_OK);
+      const int before = allocations;
+      CHECK(skyscraper_create_dlx(size, seed, board.data(), board.size(), clues.data(),
+                                  clues.size(), workspace.data(), workspace_len) == SKYSCRAPER_OK);
+      CHECK(allocations == before);
+      CHECK(board == expected_board);
+      CHECK(clues == expected_clues);
+
+      // Without a board, the cells go to the workspace.
+      std::vector<int> only_clues(4 * size);
+      CHECK(skyscraper_create_dlx(size, seed, nullptr, 0, only_clues.data(), only_clues.size(),
+                                  workspace.data(), workspace_len) == SKYSCRAPER_OK);
+      CHECK(only_clues == expected_clues);
+    }
+    CHECK(skyscraper_create_dlx(size, 1, board.data(), board.size(), clues.data(), clues.size(),
+                                workspace.data(), workspace_len - 1) ==
+          SKYSCRAPER_BUFFER_TOO_SMALL);
+    CHECK(skyscraper_create_dlx(size, 1, board.data(), board.size() - 1, clues.data(),
+                                clues.size(), workspace.data(), workspace_len) ==
+          SKYSCRAPER_BUFFER_TOO_SMALL);
+  }
+  CHECK(skyscraper_create_workspace_size(1) == 0);
+  std::vector<uint64_t> workspace(16);
+  CHECK(skyscraper_create_dlx(1, 1, nullptr, 0, nullptr, 0, workspace.data(), 128) ==
+        SKYSCRAPER_INVALID_ARGUMENT);
+  CHECK(skyscraper_create_dlx(4, 1, nullptr, 0, nullptr, 0,
+                              reinterpret_cast<char*>(workspace.data()) + 1, 127) ==
+        SKYSCRAPER_INVALID_ARGUMENT);
+}
+
+}  // namespace
+
+int main() {
+  check_create_dlx();
+  return check_result();
+}
@@ -0,0 +1,126 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <random>
+#include <vector>
+
+#include "cdcl.h"
+#include "check.h"
+#include "solve.h"
+
+namespace {
+
+// Returns whether the solution is a Latin square that matches every
+// nonzero clue.
+bool matches_clues(const int size, const std::vector<int>& clues,
+                   const std::vector<int>& solution) {
+  std::vector<int> solved_clues(4 * size);
+  compute_clues(size, solution.data(), solved_clues.data());
+  for (int i = 0; i < 4 * size; ++i) {
+    if (clues[i] != 0 && clues[i] != solved_clues[i])
+      return false;
+  }
+  for (int i = 0; i < size; ++i) {
+    std::vector<bool> in_row(size + 1), in_column(size + 1);
+    for (int j = 0; j < size; ++j) {
+      const int row_value = solution[i * size + j];
+      const int column_value = solution[j * size + i];
+      if (row_value < 1 || row_value > size || in_row[row_value] ||
+          column_value < 1 || column_value > size || in_column[column_value])
+        return false;
+      in_row[row_value] = in_column[column_value] = true;
+    }
+  }
+  return true;
+}
+
+// Counts the outcomes of the puzzles compared so far.
+struct Outcomes {
+  int compared = 0;
+  int no_solution = 0;
+  int unique = 0;
+  int ambiguous = 0;
+};
+
+// With `max_solutions` set to 2, CDCL must agree with the search on
+// whether a puzzle has no, one or several solutions. Removing clues
+// makes most of the puzzles ambiguous, which exercises the blocking
+// clauses CDCL adds to look for a second solution; raising one of the
+// clues left makes some of them infeasible. Puzzles the search cannot
+// settle within its node budget are skipped.
+void check_agrees_with_search(const int size, const double keep, std::mt19937& generator,
+                              Outcomes* outcomes) {
+  std::vector<unsigned char> workspace(solve_workspace_size(size));
+  SolverOptions options;
+  options.max_solutions = 2;
+  SolverOptions search_options = options;
+  search_options.max_nodes = 1000000;
+  int compared = 0;
+  for (int i = 0; i < 20; ++i) {
+    const std::vector<int> cells = random_cells(size, generator);
+    std::vector<int> clues = random_clues(size, cells, keep, generator);
+    if (i % 2 == 1) {
+      for (int& clue : clues) {
+        if (clue != 0) {
+          clue = clue % size + 1;
+          break;
+        }
+      }
+    }
+    std::vector<int> expected(size * size);
+    SolverStats expected_stats;
+    const SolveStatus expected_status =
+      solve_clues(size, clues.data(), search_options, expected.data(), workspace.data(),
+                  workspace.size(), &expected_stats);
+    if (expected_status == SolveStatus::CANCELLED)
+      continue;
+    std::vector<int> solution(size * size);
+    SolverStats stats;
+    const SolveStatus status =
+      solve_clues_cdcl(size, clues.data(), options, solution.data(), &stats);
+    CHECK(status == expected_status);
+    CHECK(stats.solutions == expected_stats.solutions);
+    if (status == SolveStatus::SOLVED)
+      CHECK(matches_clues(size, clues, solution));
+    ++compared;
+    outcomes->no_solution += expected_stats.solutions == 0;
+    outcomes->unique += expected_stats.solutions == 1;
+    outcomes->ambiguous += expected_stats.solutions > 1;
+  }
+  CHECK(compared >= 15);
+  outcomes->compared += compared;
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  Outcomes outcomes;
+  // Only the smaller puzzles are often unique with clues alone.
+  for (int size = 4; size <= 6; ++size)
+    check_agrees_with_search(size, 1.0, generator, &outcomes);
+  for (int size = 7; size <= 8; ++size)
+    check_agrees_with_search(size, 0.5, generator, &outcomes);
+  for (int size = 9; size <= 10; ++size)
+    check_agrees_with_search(size, 0.4, generator, &outcomes);
+  CHECK(outcomes.no_solution > 0);
+  CHECK(outcomes.unique > 0);
+  CHECK(outcomes.ambiguous > 0);
+  return check_result();
+}
@@ -0,0 +1,82 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "board.h"
+#include "create.h"
+#include "puzzle.h"
+
+// A minimal harness: CHECK reports a failed condition and carries on,
+// and `check_result()` turns the failures into the exit status.
+
+inline int& check_failures() {
+  static int failures = 0;
+  return failures;
+}
+
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: "    \
+                << #condition << std::endl;                             \
+      ++check_failures();                                               \
+    }                                                                   \
+  } while (0)
+
+inline int check_result() {
+  if (check_failures() > 0) {
+    std::cerr << check_failures() << " checks failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// Returns the cells of a random board, in row-major order.
+inline std::vector<int> random_cells(const int size, std::mt19937& generator) {
+  const std::optional<Board> b = run_creation_algorithm(CreateMode::DLX, size, generator);
+  std::vector<int> cells(size * size);
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column)
+      cells[row * size + column] = b->at(row, column);
+  }
+  return cells;
+}
+
+// Returns the clues of a board, with each one kept with probability
+// `keep`.
+inline std::vector<int> random_clues(const int size, const std::vector<int>& cells,
+                                     const double keep, std::mt19937& generator) {
+  std::vector<int> clues(4 * size);
+  compute_clues(size, cells.data(), clues.data());
+  std::bernoulli_distribution kept{keep};
+  for (int& clue : clues) {
+    if (!kept(generator))
+      clue = 0;
+  }
+  return clues;
+}
+
+#endif
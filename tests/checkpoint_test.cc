@@ -0,0 +1,116 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+#include "board.h"
+#include "check.h"
+#include "create_random.h"
+
+namespace {
+
+constexpr int SIZE = 9;
+
+std::string read_file(const std::string& path) {
+  std::ifstream in{path, std::ios::in | std::ios::binary};
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::string& data) {
+  std::ofstream out{path, std::ios::out | std::ios::binary | std::ios::trunc};
+  out << data;
+}
+
+// Stops a search part of the way, leaving a checkpoint at `path`.
+void interrupt(const std::string& path, const uint64_t seed) {
+  std::mt19937 generator(seed);
+  Board b{SIZE};
+  const RandomCheckpoint checkpoint{.path = path.c_str(), .interval = 10, .max_iterations = 25};
+  CHECK(!fill_random_board(b, generator, checkpoint));
+  CHECK(std::filesystem::exists(path));
+}
+
+// A search that is stopped and resumed, possibly more than once, ends
+// with the board of an uninterrupted search from the same seed.
+void check_resume(const std::string& path, const uint64_t seed) {
+  std::mt19937 reference_generator(seed);
+  Board reference{SIZE};
+  CHECK(fill_random_board(reference, reference_generator));
+
+  interrupt(path, seed);
+  std::mt19937 generator;
+  Board b{SIZE};
+  RandomCheckpoint checkpoint{.path = path.c_str(), .resume = true, .interval = 10,
+                              .max_iterations = 25};
+  CHECK(!fill_random_board(b, generator, checkpoint));
+  CHECK(std::filesystem::exists(path));
+  checkpoint.max_iterations = 0;
+  CHECK(fill_random_board(b, generator, checkpoint));
+  CHECK(b == reference);
+  CHECK(!std::filesystem::exists(path));
+}
+
+// A damaged checkpoint is refused, and left in place.
+void check_rejected(const std::string& path, const std::string& data) {
+  write_file(path, data);
+  std::mt19937 generator;
+  Board b{SIZE};
+  const RandomCheckpoint checkpoint{.path = path.c_str(), .resume = true};
+  CHECK(!fill_random_board(b, generator, checkpoint));
+  CHECK(std::filesystem::exists(path));
+}
+
+void check_corruption(const std::string& path) {
+  interrupt(path, 7);
+  const std::string saved = read_file(path);
+  // The header is followed by the generator state, then by the value
+  // of the first cell.
+  uint64_t generator_length;
+  memcpy(&generator_length, saved.data() + 24, sizeof(generator_length));
+  const size_t first_value = 32 + generator_length;
+  CHECK(saved.size() > first_value + 2);
+
+  check_rejected(path, saved.substr(0, saved.size() - 1));
+  check_rejected(path, saved.substr(0, first_value + 1));
+  check_rejected(path, saved + '\0');
+  std::string out_of_range = saved;
+  out_of_range[first_value] = SIZE + 1;
+  check_rejected(path, out_of_range);
+  std::string bad_magic = saved;
+  bad_magic[0] = 'X';
+  check_rejected(path, bad_magic);
+  std::filesystem::remove(path);
+}
+
+}  // namespace
+
+int main() {
+  const std::string path =
+    (std::filesystem::temp_directory_path() / "checkpoint_test.checkpoint").string();
+  for (const uint64_t seed : {1, 2, 3})
+    check_resume(path, seed);
+  check_corruption(path);
+  return check_result();
+}
@@ -0,0 +1,132 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "board.h"
+#include "check.h"
+#include "create.h"
+#include "dlx.h"
+
+namespace {
+
+Board to_board(const int size, const std::vector<int>& cells) {
+  Board b{size};
+  for (int i = 0; i < size * size; ++i) {
+    if (cells[i] != 0)
+      b.set(cells[i], i / size, i % size);
+  }
+  return b;
+}
+
+// Every fill is a Latin square, whether the arena is allocated by the
+// cover or provided by the caller, and fixed values stay in place.
+void check_cover(const int size, std::mt19937& generator) {
+  std::vector<uint64_t> workspace(LatinSquareCover::workspace_size(size) / sizeof(uint64_t) + 1);
+  LatinSquareCover owned{size};
+  LatinSquareCover borrowed{size, workspace.data()};
+  std::vector<int> cells(size * size);
+  for (int i = 0; i < 20; ++i) {
+    CHECK(owned.solve(&generator, cells.data()));
+    CHECK(to_board(size, cells).is_valid());
+    CHECK(borrowed.solve(&generator, cells.data()));
+    CHECK(to_board(size, cells).is_valid());
+  }
+
+  // Fix the first row of a random board, and a conflicting value.
+  const std::vector<int> board = random_cells(size, generator);
+  for (int column = 0; column < size; ++column)
+    CHECK(borrowed.fix(0, column, board[column]));
+  if (size > 1)
+    CHECK(!borrowed.fix(1, 0, board[0]));
+  for (int i = 0; i < 20; ++i) {
+    CHECK(borrowed.solve(&generator, cells.data()));
+    CHECK(to_board(size, cells).is_valid());
+    for (int column = 0; column < size; ++column)
+      CHECK(cells[column] == board[column]);
+  }
+  borrowed.clear();
+  if (size > 1)
+    CHECK(borrowed.fix(1, 0, board[0]));
+}
+
+// Both completion searches return a Latin square that keeps every
+// filled cell of a feasible partial board.
+void check_completion(const CreateMode mode, const int size, std::mt19937& generator) {
+  std::bernoulli_distribution kept{0.5};
+  for (int i = 0; i < 20; ++i) {
+    std::vector<int> cells = random_cells(size, generator);
+    for (int& cell : cells) {
+      if (!kept(generator))
+        cell = 0;
+    }
+    const Board partial = to_board(size, cells);
+    CHECK(is_partial_board_feasible(partial));
+    const std::optional<Board> completed = run_completion_algorithm(mode, partial, generator);
+    CHECK(completed.has_value());
+    if (!completed.has_value())
+      continue;
+    CHECK(completed->is_valid());
+    for (int j = 0; j < size * size; ++j)
+      CHECK(cells[j] == 0 || completed->at(j / size, j % size) == cells[j]);
+  }
+}
+
+// Partial boards without a completion are rejected by both searches,
+// whether they repeat a value or only fail the matching condition.
+void check_infeasible(const CreateMode mode, std::mt19937& generator) {
+  // Row 0 repeats a 1.
+  const Board repeated_row = to_board(4, {1, 0, 1, 0,
+                                          0, 0, 0, 0,
+                                          0, 0, 0, 0,
+                                          0, 0, 0, 0});
+  // Column 2 repeats a 3.
+  const Board repeated_column = to_board(4, {0, 0, 3, 0,
+                                             0, 0, 0, 0,
+                                             0, 0, 3, 0,
+                                             0, 0, 0, 0});
+  // Row 0 misses a 3, but both its free cells are in columns that
+  // already hold one.
+  const Board unmatched = to_board(4, {1, 2, 0, 0,
+                                       0, 0, 3, 0,
+                                       0, 0, 0, 3,
+                                       0, 0, 0, 0});
+  for (const Board* partial : {&repeated_row, &repeated_column, &unmatched}) {
+    CHECK(!is_partial_board_feasible(*partial));
+    CHECK(!run_completion_algorithm(mode, *partial, generator).has_value());
+  }
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  for (int size = 1; size <= 12; ++size) {
+    check_cover(size, generator);
+    check_completion(CreateMode::DLX, size, generator);
+  }
+  for (int size = 1; size <= 8; ++size)
+    check_completion(CreateMode::RANDOM, size, generator);
+  check_infeasible(CreateMode::DLX, generator);
+  check_infeasible(CreateMode::RANDOM, generator);
+  return check_result();
+}
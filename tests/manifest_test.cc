@@ -0,0 +1,87 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "manifest.h"
+
+namespace {
+
+std::string read_file(const std::string& path) {
+  std::ifstream in{path};
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::string temporary(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / ("manifest_test_" + name)).string();
+}
+
+// The output does not depend on how many threads write it, nor on how
+// the jobs are split.
+void check_threads() {
+  std::vector<std::string> reference;
+  for (const int threads : {1, 2, 7}) {
+    const std::vector<ManifestJob> jobs = {
+      {CreateMode::SHUFFLE, 5, 1, 300, temporary("shuffle.txt"), temporary("shuffle.sol")},
+      {CreateMode::DLX, 6, 10, 500, temporary("dlx.txt"), ""},
+      {CreateMode::RANDOM, 4, 3, 1, temporary("random.txt"), temporary("random.sol")},
+    };
+    CostModel costs;
+    CHECK(run_jobs(jobs, threads, costs));
+    std::vector<std::string> output;
+    for (const ManifestJob& job : jobs) {
+      output.push_back(read_file(job.output_file));
+      if (!job.solution_file.empty())
+        output.push_back(read_file(job.solution_file));
+      std::filesystem::remove(job.output_file);
+      std::filesystem::remove(job.solution_file);
+    }
+    if (reference.empty())
+      reference = output;
+    CHECK(output == reference);
+  }
+  CHECK(!reference[0].empty());
+  CHECK(!reference[1].empty());
+}
+
+// A file that cannot be opened or written fails the run.
+void check_errors() {
+  for (const auto& [output, solution] : std::vector<std::pair<std::string, std::string>>{
+         {"/nonexistent/manifest_test.txt", ""},
+         {temporary("ok.txt"), "/nonexistent/manifest_test.sol"},
+         {"/dev/full", ""},
+       }) {
+    CostModel costs;
+    CHECK(!run_jobs({{CreateMode::SHUFFLE, 4, 1, 5, output, solution}}, 2, costs));
+  }
+  std::filesystem::remove(temporary("ok.txt"));
+}
+
+}  // namespace
+
+int main() {
+  check_threads();
+  check_errors();
+  return check_result();
+}
@@ -0,0 +1,122 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "portfolio.h"
+#include "puzzle.h"
+#include "solve.h"
+
+namespace {
+
+// Returns the number of solutions of a puzzle, up to 2, by a plain
+// search.
+int count_solutions(const int size, const std::vector<int>& clues) {
+  std::vector<unsigned char> workspace(solve_workspace_size(size));
+  std::vector<int> solution(size * size);
+  SolverOptions options;
+  options.max_solutions = 2;
+  SolverStats stats;
+  solve_clues(size, clues.data(), options, solution.data(), workspace.data(), workspace.size(),
+              &stats);
+  return stats.solutions;
+}
+
+// The portfolio agrees with the search on the number of solutions, and
+// its solution matches the clues, whether the puzzle is answered alone
+// or raced.
+void check_answers(const int size, const long solo_nodes, std::mt19937& generator) {
+  PortfolioOptions options;
+  options.max_solutions = 2;
+  options.solo_nodes = solo_nodes;
+  for (int i = 0; i < 20; ++i) {
+    const std::vector<int> cells = random_cells(size, generator);
+    const std::vector<int> clues = random_clues(size, cells, 0.5, generator);
+    SolveStatus status;
+    SolverStats stats;
+    const std::optional<Board> b =
+      solve_portfolio(Puzzle{size, clues.data()}, options, &status, &stats);
+    CHECK(status == SolveStatus::SOLVED);
+    CHECK(stats.solutions == count_solutions(size, clues));
+    CHECK(b.has_value());
+    if (b.has_value()) {
+      const std::vector<int> solved = Puzzle{*b}.clues();
+      for (int j = 0; j < 4 * size; ++j)
+        CHECK(clues[j] == 0 || clues[j] == solved[j]);
+    }
+  }
+}
+
+// Races started from several threads at once share the pool.
+void check_concurrent_races() {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([t] {
+      std::mt19937 generator(100 + t);
+      check_answers(6, 1, generator);
+    });
+  }
+  for (std::thread& t : threads)
+    t.join();
+}
+
+// An outside cancellation stops the race.
+void check_cancel(std::mt19937& generator) {
+  const int size = 7;
+  const std::vector<int> cells = random_cells(size, generator);
+  const std::vector<int> clues = random_clues(size, cells, 0.3, generator);
+  const std::atomic<bool> cancel{true};
+  PortfolioOptions options;
+  options.cancel = &cancel;
+  options.solo_nodes = 1;
+  SolveStatus status;
+  CHECK(!solve_portfolio(Puzzle{size, clues.data()}, options, &status).has_value());
+  CHECK(status == SolveStatus::CANCELLED);
+}
+
+void check_default_portfolio() {
+  const std::vector<PortfolioStrategy> strategies = default_portfolio();
+  CHECK(int(strategies.size()) <= MAX_PORTFOLIO_STRATEGIES);
+  CHECK(std::any_of(strategies.begin(), strategies.end(), [](const PortfolioStrategy& s) {
+    return s.options.variable_order == VariableOrder::ROW_MAJOR;
+  }));
+  CHECK(std::any_of(strategies.begin(), strategies.end(), [](const PortfolioStrategy& s) {
+    return s.options.backend == SolverBackend::CDCL;
+  }));
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  check_default_portfolio();
+  for (int size = 4; size <= 7; ++size) {
+    for (const long solo_nodes : {0L, 1L, 2000L})
+      check_answers(size, solo_nodes, generator);
+  }
+  check_concurrent_races();
+  check_cancel(generator);
+  return check_result();
+}
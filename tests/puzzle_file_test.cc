@@ -0,0 +1,164 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+#include "create.h"
+#include "puzzle.h"
+#include "puzzle_file.h"
+
+namespace {
+
+// Mirrors the smallest share of the file that puzzle_file.cc gives a
+// worker.
+constexpr size_t MIN_BYTES_PER_WORKER = 1 << 20;
+
+// A parsed puzzle: its byte offset and its clues.
+using Parsed = std::pair<size_t, std::vector<int>>;
+
+std::string temporary(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / ("puzzle_file_test_" + name)).string();
+}
+
+void write_file(const std::string& path, const std::string& contents) {
+  std::ofstream out{path, std::ios::binary};
+  out << contents;
+}
+
+// Parses the file with the given thread count, and returns the
+// puzzles sorted by offset, or nothing if parsing fails.
+std::optional<std::vector<Parsed>> parse(const std::string& path, const int threads) {
+  std::mutex mutex;
+  std::vector<Parsed> parsed;
+  bool workers_in_range = true;
+  const std::optional<uint64_t> count = parse_puzzle_file(
+    path.c_str(), threads,
+    [&](const int worker, const size_t offset, const int size, const int* clues) {
+      std::lock_guard<std::mutex> lock{mutex};
+      workers_in_range = workers_in_range && worker >= 0 && worker < threads;
+      parsed.emplace_back(offset, std::vector<int>(clues, clues + 4 * size));
+      return true;
+    });
+  CHECK(workers_in_range);
+  if (!count.has_value())
+    return std::nullopt;
+  CHECK(*count == parsed.size());
+  std::sort(parsed.begin(), parsed.end());
+  return parsed;
+}
+
+// Every thread count finds the same puzzles at the same offsets. The
+// file is large enough for four workers, and every puzzle takes the
+// same number of bytes, so that the split points of two and four
+// workers land exactly on the start of a puzzle, while those of three
+// workers land inside one.
+void check_split() {
+  std::mt19937 generator{1};
+  std::ostringstream contents;
+  std::vector<Parsed> expected;
+  size_t record = 0;
+  for (int i = 0; i < 40000; ++i) {
+    const std::optional<Board> b = run_creation_algorithm(CreateMode::DLX, 6, generator);
+    const Puzzle puzzle{*b};
+    const size_t offset = contents.tellp();
+    puzzle.print(contents);
+    contents << '\n';
+    record = size_t(contents.tellp()) - offset;
+    expected.emplace_back(offset, puzzle.clues());
+  }
+  const size_t length = contents.tellp();
+  CHECK(length == record * expected.size());
+  CHECK(length >= 4 * MIN_BYTES_PER_WORKER);
+  CHECK(length / 2 % record == 0);
+  CHECK(length / 4 % record == 0);
+  CHECK(length / 3 % record != 0);
+
+  const std::string path = temporary("split.txt");
+  write_file(path, contents.str());
+  for (int threads = 1; threads <= 6; ++threads) {
+    const std::optional<std::vector<Parsed>> parsed = parse(path, threads);
+    CHECK(parsed.has_value());
+    CHECK(parsed.has_value() && *parsed == expected);
+  }
+
+  // A malformed puzzle in the middle fails the whole file.
+  std::string broken = contents.str();
+  broken[length / 2 + 1] = 'x';
+  write_file(path, broken);
+  for (int threads = 1; threads <= 4; ++threads)
+    CHECK(!parse(path, threads).has_value());
+  std::filesystem::remove(path);
+}
+
+// Truncated puzzles and out-of-range clues are rejected.
+void check_malformed() {
+  const std::string path = temporary("malformed.txt");
+  const std::string puzzle =
+    " 2 1 \n"
+    "2   1\n"
+    "1   2\n"
+    " 1 2 \n";
+  write_file(path, puzzle + "\n" + puzzle);
+  const std::optional<std::vector<Parsed>> parsed = parse(path, 1);
+  CHECK(parsed.has_value() && parsed->size() == 2);
+  CHECK(parsed.has_value() && (*parsed)[1].first == puzzle.size() + 1);
+  CHECK(parsed.has_value() && (*parsed)[1].second == std::vector<int>({2, 1, 1, 2, 2, 1, 1, 2}));
+
+  const std::vector<std::string> malformed = {
+    // The bottom clues are missing.
+    puzzle.substr(0, puzzle.rfind(" 1 2")),
+    // A row has a single clue.
+    " 2 1 \n2\n1   2\n 1 2 \n",
+    // A clue exceeds the size.
+    " 2 3 \n2   1\n1   2\n 1 2 \n",
+    // A clue exceeds the largest size the parser accepts.
+    " 2 65 \n2   1\n1   2\n 1 2 \n",
+    // The top clues hold something other than numbers.
+    " 2 a \n2   1\n1   2\n 1 2 \n",
+  };
+  for (const std::string& contents : malformed) {
+    write_file(path, puzzle + "\n" + contents);
+    CHECK(!parse(path, 1).has_value());
+  }
+
+  write_file(path, "");
+  const std::optional<std::vector<Parsed>> empty = parse(path, 4);
+  CHECK(empty.has_value() && empty->empty());
+  std::filesystem::remove(path);
+  CHECK(!parse(path, 1).has_value());
+}
+
+}  // namespace
+
+int main() {
+  check_split();
+  check_malformed();
+  return check_result();
+}
@@ -0,0 +1,122 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "check.h"
+#include "create.h"
+#include "puzzle.h"
+#include "shard.h"
+
+namespace {
+
+std::string temporary(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / ("shard_test_" + name)).string();
+}
+
+// Writes the records of seeds `first` through `first + count - 1`.
+std::string write_records(const std::string& name, const CreateMode mode, const int size,
+                          const uint64_t first, const int count) {
+  const std::string path = temporary(name);
+  std::ofstream out{path};
+  for (uint64_t seed = first; seed < first + count; ++seed) {
+    std::mt19937 generator = make_generator(seed);
+    const std::optional<Board> b = run_creation_algorithm(mode, size, generator);
+    write_record(out, seed, mode, *b, Puzzle{*b});
+  }
+  return path;
+}
+
+// Records of the same seed in other modes or sizes are all kept, and
+// only identical ones are dropped.
+void check_merge() {
+  const std::vector<std::string> paths = {
+    write_records("shuffle4.rec", CreateMode::SHUFFLE, 4, 1, 10),
+    write_records("dlx5.rec", CreateMode::DLX, 5, 5, 10),
+    write_records("shuffle4_again.rec", CreateMode::SHUFFLE, 4, 1, 10),
+    write_records("shuffle5.rec", CreateMode::SHUFFLE, 5, 1, 3),
+  };
+  std::vector<const char*> inputs;
+  for (const std::string& path : paths)
+    inputs.push_back(path.c_str());
+  std::ostringstream out;
+  uint64_t merged;
+  uint64_t duplicates;
+  CHECK(merge_records(inputs.data(), inputs.size(), out, &merged, &duplicates));
+  CHECK(merged == 23);
+  CHECK(duplicates == 10);
+
+  // The output is sorted by seed, and the first record is a 4x4
+  // shuffle one, from the earliest input.
+  std::istringstream lines{out.str()};
+  std::string line;
+  uint64_t previous = 0;
+  int count = 0;
+  while (std::getline(lines, line)) {
+    const uint64_t seed = std::stoull(line);
+    CHECK(seed >= previous);
+    previous = seed;
+    if (count++ == 0)
+      CHECK(line.rfind("1 shuffle 4 ", 0) == 0);
+  }
+  CHECK(count == 23);
+
+  // Merging the output again changes nothing.
+  const std::string merged_path = temporary("merged.rec");
+  {
+    std::ofstream merged_out{merged_path};
+    merged_out << out.str();
+  }
+  const char* again[] = {merged_path.c_str(), merged_path.c_str()};
+  std::ostringstream out_again;
+  CHECK(merge_records(again, 2, out_again, &merged, &duplicates));
+  CHECK(out_again.str() == out.str());
+  CHECK(duplicates == 23);
+
+  for (const std::string& path : paths)
+    std::filesystem::remove(path);
+  std::filesystem::remove(merged_path);
+}
+
+void check_shard_seeds() {
+  CHECK(shard_first_seed(0, 4) == 0);
+  CHECK(shard_first_seed(1, 4) == uint64_t(1) << 62);
+  CHECK(shard_first_seed(3, 4) == uint64_t(3) << 62);
+  uint32_t index;
+  uint32_t count;
+  CHECK(parse_shard("3/8", &index, &count) && index == 3 && count == 8);
+  CHECK(!parse_shard("8/8", &index, &count));
+  CHECK(!parse_shard("1/0", &index, &count));
+  CHECK(!parse_shard("1", &index, &count));
+}
+
+}  // namespace
+
+int main() {
+  check_merge();
+  check_shard_seeds();
+  return check_result();
+}
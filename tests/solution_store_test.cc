@@ -0,0 +1,143 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cdcl.h"
+#include "check.h"
+#include "solution_store.h"
+#include "solve.h"
+
+namespace {
+
+// Every board is found in the store by its clues, with an answer that
+// has the same clues, and the store agrees with both solvers on
+// whether that answer is unique.
+void check_store(const int size, const int threads, std::mt19937& generator) {
+  const std::string path = (std::filesystem::temp_directory_path() /
+                            ("solution_store_test_" + std::to_string(size) + ".store")).string();
+  CHECK(build_solution_store(size, path.c_str(), threads));
+  CHECK(!std::filesystem::exists(path + ".tmp"));
+  std::optional<SolutionStore> store = SolutionStore::open(path.c_str());
+  CHECK(store.has_value());
+  if (!store.has_value())
+    return;
+  CHECK(store->size() == size);
+
+  std::vector<unsigned char> workspace(solve_workspace_size(size));
+  std::vector<int> solution(size * size);
+  for (int i = 0; i < 200; ++i) {
+    const std::vector<int> cells = random_cells(size, generator);
+    std::vector<int> clues(4 * size);
+    compute_clues(size, cells.data(), clues.data());
+    const std::optional<StoreAnswer> answer = store->lookup(clues.data());
+    CHECK(answer.has_value());
+    if (!answer.has_value())
+      continue;
+    std::vector<int> answer_clues(4 * size);
+    compute_clues(size, answer->solution.data(), answer_clues.data());
+    CHECK(answer_clues == clues);
+
+    SolverOptions options;
+    options.max_solutions = 2;
+    SolverStats search_stats;
+    CHECK(solve_clues(size, clues.data(), options, solution.data(), workspace.data(),
+                      workspace.size(), &search_stats) == SolveStatus::SOLVED);
+    SolverStats cdcl_stats;
+    CHECK(solve_clues_cdcl(size, clues.data(), options, solution.data(), &cdcl_stats) ==
+          SolveStatus::SOLVED);
+    CHECK(answer->unique == (search_stats.solutions == 1));
+    CHECK(answer->unique == (cdcl_stats.solutions == 1));
+  }
+
+  // No board has a clue of 1 on both ends of a line.
+  std::vector<int> impossible(4 * size, 1);
+  CHECK(!store->lookup(impossible.data()).has_value());
+  std::remove(path.c_str());
+}
+
+// Writes a copy of the store at `path` whose header claims
+// `capacity` slots, after `change` edits its bytes.
+template <typename Change>
+std::string corrupted_copy(const std::string& path, const uint64_t capacity, Change change) {
+  std::ifstream in{path, std::ios::in | std::ios::binary};
+  std::string data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  // The capacity follows the magic, the version and the size.
+  memcpy(data.data() + 16, &capacity, sizeof(capacity));
+  change(data);
+  const std::string copy = path + ".corrupted";
+  std::ofstream out{copy, std::ios::out | std::ios::binary | std::ios::trunc};
+  out << data;
+  return copy;
+}
+
+// A capacity that does not fit the file is refused, even when its
+// byte count wraps around, and a table without empty slots does not
+// stall lookups.
+void check_corrupted_store() {
+  const std::string path = (std::filesystem::temp_directory_path() /
+                            "solution_store_test_corrupted.store").string();
+  CHECK(build_solution_store(4, path.c_str(), 1));
+
+  const std::string wrapping = corrupted_copy(path, uint64_t(1) << 59, [](std::string&) {});
+  CHECK(!SolutionStore::open(wrapping.c_str()).has_value());
+  std::remove(wrapping.c_str());
+
+  // A single slot, holding an entry, leaves no empty slot to end a
+  // probe. Entries are 32 bytes, after a 64-byte header, and empty
+  // ones have a zero second key word.
+  const std::string full = corrupted_copy(path, 1, [](std::string& data) {
+    for (size_t offset = 64; offset + 32 <= data.size(); offset += 32) {
+      uint64_t key;
+      memcpy(&key, data.data() + offset + 8, sizeof(key));
+      if (key != 0) {
+        memmove(data.data() + 64, data.data() + offset, 32);
+        return;
+      }
+    }
+  });
+  std::optional<SolutionStore> store = SolutionStore::open(full.c_str());
+  CHECK(store.has_value());
+  if (store.has_value()) {
+    std::vector<int> impossible(16, 1);
+    CHECK(!store->lookup(impossible.data()).has_value());
+  }
+  std::remove(full.c_str());
+  std::remove(path.c_str());
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  check_store(4, 1, generator);
+  check_store(4, 3, generator);
+  check_store(5, 2, generator);
+  check_corrupted_store();
+  return check_result();
+}
@@ -0,0 +1,143 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <random>
+#include <vector>
+
+#include "cdcl.h"
+#include "check.h"
+#include "rating.h"
+#include "skyscraper.h"
+#include "solve.h"
+#include "symmetry.h"
+
+namespace {
+
+// Every solution the search reports must match the clues it was given.
+void check_solutions_match_clues(const int size, std::mt19937& generator) {
+  std::vector<unsigned char> workspace(solve_workspace_size(size));
+  for (int i = 0; i < 50; ++i) {
+    const std::vector<int> cells = random_cells(size, generator);
+    const std::vector<int> clues = random_clues(size, cells, 0.7, generator);
+    std::vector<int> solution(size * size);
+    SolverOptions options;
+    SolverStats stats;
+    CHECK(solve_clues(size, clues.data(), options, solution.data(), workspace.data(),
+                      workspace.size(), &stats) == SolveStatus::SOLVED);
+    std::vector<int> solved_clues(4 * size);
+    compute_clues(size, solution.data(), solved_clues.data());
+    for (int j = 0; j < 4 * size; ++j)
+      CHECK(clues[j] == 0 || clues[j] == solved_clues[j]);
+  }
+}
+
+// Propagation must not depend on the orientation of the puzzle: the
+// candidates left in the image of a puzzle are the images of the
+// candidates left in the puzzle itself.
+void check_propagation_is_symmetric(const int size, std::mt19937& generator) {
+  const size_t len = SolverState::workspace_size(size);
+  std::vector<CandidateMask> original_space(len / sizeof(CandidateMask) + 1);
+  std::vector<CandidateMask> image_space(len / sizeof(CandidateMask) + 1);
+  for (int i = 0; i < 200; ++i) {
+    const std::vector<int> cells = random_cells(size, generator);
+    const std::vector<int> clues = random_clues(size, cells, 0.5, generator);
+    SolverState original{size, clues.data(), original_space.data(), len};
+    const bool consistent = original.initialize();
+    CHECK(consistent);
+    for (int t = 1; t < SYMMETRIES; ++t) {
+      std::vector<int> image_clues(4 * size);
+      transform_clues(t, size, clues.data(), image_clues.data());
+      SolverState image{size, image_clues.data(), image_space.data(), len};
+      CHECK(image.initialize() == consistent);
+      for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+          CHECK(image.candidates(row * size + column) ==
+                original.candidates(transformed_index(t, size, row, column)));
+        }
+      }
+    }
+  }
+}
+
+// Ratings must be the same for every rotation and reflection.
+void check_rating_is_symmetric(const int size, std::mt19937& generator) {
+  const size_t len = SolverState::workspace_size(size);
+  std::vector<CandidateMask> workspace(len / sizeof(CandidateMask) + 1);
+  const DifficultyBand all{Difficulty::EASY, Difficulty::EXPERT};
+  for (int i = 0; i < 200; ++i) {
+    const std::vector<int> cells = random_cells(size, generator);
+    const std::vector<int> clues = random_clues(size, cells, 0.5, generator);
+    Rating original;
+    rate_clues(size, clues.data(), all, workspace.data(), len, &original);
+    for (int t = 1; t < SYMMETRIES; ++t) {
+      std::vector<int> image_clues(4 * size);
+      transform_clues(t, size, clues.data(), image_clues.data());
+      Rating image;
+      rate_clues(size, image_clues.data(), all, workspace.data(), len, &image);
+      CHECK(image.difficulty == original.difficulty);
+      CHECK(image.guessed == original.guessed);
+    }
+  }
+}
+
+// The default backend is the search for small puzzles and CDCL for
+// the larger ones it can handle.
+void check_backend_choice() {
+  CHECK(pick_backend(SolverBackend::AUTO, 4) == SolverBackend::SEARCH);
+  CHECK(pick_backend(SolverBackend::AUTO, MAX_SEARCH_BACKEND_SIZE) == SolverBackend::SEARCH);
+  CHECK(pick_backend(SolverBackend::AUTO, MAX_SEARCH_BACKEND_SIZE + 1) == SolverBackend::CDCL);
+  CHECK(pick_backend(SolverBackend::AUTO, MAX_CDCL_SIZE + 1) == SolverBackend::SEARCH);
+  CHECK(pick_backend(SolverBackend::SEARCH, 16) == SolverBackend::SEARCH);
+  CHECK(pick_backend(SolverBackend::CDCL, 4) == SolverBackend::CDCL);
+}
+
+// The C interface creates boards whose clues have them as a solution.
+void check_c_api(const int size) {
+  std::vector<int> board(size * size);
+  std::vector<int> clues(4 * size);
+  CHECK(skyscraper_create(SKYSCRAPER_CREATE_DLX, size, 7, board.data(), board.size(),
+                          clues.data(), clues.size()) == SKYSCRAPER_OK);
+  std::vector<unsigned char> workspace(skyscraper_solve_workspace_size(size));
+  std::vector<int> solution(size * size);
+  int count = 0;
+  CHECK(skyscraper_count_solutions(size, clues.data(), clues.size(), 2, &count,
+                                   solution.data(), solution.size(), workspace.data(),
+                                   workspace.size()) == SKYSCRAPER_OK);
+  CHECK(count >= 1);
+  std::vector<int> solved_clues(4 * size);
+  CHECK(skyscraper_compute_clues(size, solution.data(), solution.size(), solved_clues.data(),
+                                 solved_clues.size()) == SKYSCRAPER_OK);
+  CHECK(solved_clues == clues);
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  check_backend_choice();
+  for (int size = 3; size <= 7; ++size) {
+    check_solutions_match_clues(size, generator);
+    check_c_api(size);
+  }
+  for (int size = 4; size <= 6; ++size) {
+    check_propagation_is_symmetric(size, generator);
+    check_rating_is_symmetric(size, generator);
+  }
+  return check_result();
+}
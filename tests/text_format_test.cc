@@ -0,0 +1,119 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "check.h"
+#include "puzzle.h"
+#include "text_format.h"
+
+namespace {
+
+// The iostream rendering that `Board::print()` used before
+// TextFormatter, kept as the reference for its output.
+std::string reference_board(const int size, const std::vector<int>& cells) {
+  std::ostringstream ostream;
+  const int value_width = std::floor(std::log10(size)) + 1;
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column)
+      ostream << std::setw(value_width) << cells[row * size + column] << " ";
+    ostream << std::endl;
+  }
+  return ostream.str();
+}
+
+// Same for `Puzzle::print()`.
+std::string reference_puzzle(const Puzzle& puzzle) {
+  std::ostringstream ostream;
+  const int size = puzzle.size();
+  const int value_width = std::floor(std::log10(size)) + 1;
+  ostream << std::setw(value_width) << " ";
+  for (const int v : puzzle.top())
+    ostream << std::setw(value_width) << v << " ";
+  ostream << std::endl;
+  for (int row = 0; row < size; ++row) {
+    ostream << std::setw(value_width) << puzzle.left()[row]
+            << std::setw((value_width + 1) * size - 1) << ""
+            << std::setw(value_width) << puzzle.right()[row] << std::endl;
+  }
+  ostream << std::setw(value_width) << " ";
+  for (const int v : puzzle.bottom())
+    ostream << std::setw(value_width) << v << " ";
+  ostream << std::endl;
+  return ostream.str();
+}
+
+Board to_board(const int size, const std::vector<int>& cells) {
+  Board b{size};
+  for (int i = 0; i < size * size; ++i) {
+    if (cells[i] != 0)
+      b.set(cells[i], i / size, i % size);
+  }
+  return b;
+}
+
+// Full and partial boards, and puzzles with and without hidden clues,
+// render byte for byte as the reference does, both one at a time and
+// as a batch written at once.
+void check_size(const int size, std::mt19937& generator) {
+  TextFormatter batch;
+  std::string expected_batch;
+  for (int i = 0; i < 10; ++i) {
+    std::vector<int> cells = random_cells(size, generator);
+    const std::vector<int> clues = random_clues(size, cells, i % 2 == 0 ? 1.0 : 0.5, generator);
+    if (i % 2 == 1) {
+      for (int j = 0; j < size * size; j += 3)
+        cells[j] = 0;
+    }
+    const Board b = to_board(size, cells);
+    const Puzzle puzzle{size, clues.data()};
+
+    std::ostringstream board_text;
+    b.print(board_text);
+    CHECK(board_text.str() == reference_board(size, cells));
+    std::ostringstream puzzle_text;
+    puzzle.print(puzzle_text);
+    CHECK(puzzle_text.str() == reference_puzzle(puzzle));
+
+    batch.append(b);
+    batch.append_newline();
+    batch.append(puzzle);
+    expected_batch += reference_board(size, cells) + "\n" + reference_puzzle(puzzle);
+  }
+  CHECK(batch.size() == expected_batch.size());
+  std::ostringstream batch_text;
+  CHECK(batch.write(batch_text));
+  CHECK(batch_text.str() == expected_batch);
+  CHECK(batch.size() == 0);
+}
+
+}  // namespace
+
+int main() {
+  std::mt19937 generator{1};
+  for (const int size : {2, 9, 10, 12})
+    check_size(size, generator);
+  return check_result();
+}
@@ -0,0 +1,124 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "text_format.h"
+
+#include <charconv>
+
+#include "board.h"
+#include "puzzle.h"
+
+namespace {
+
+// The two digits of every number below 100.
+constexpr char DIGIT_PAIRS[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+// How many digits are required, at max, to print each value of a
+// board or puzzle of this size.
+int value_width(const int size) {
+  int width = 1;
+  for (int limit = 10; limit <= size; limit *= 10)
+    ++width;
+  return width;
+}
+
+}  // namespace
+
+void TextFormatter::append_number(const int value, const int width) {
+  char digits[16];
+  char* end = digits + sizeof(digits);
+  char* begin = end;
+  if (value < 0) {
+    // Never printed by this program; take the slow path.
+    begin = digits;
+    end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+  } else {
+    unsigned rest = value;
+    while (rest >= 100) {
+      begin -= 2;
+      const char* pair = &DIGIT_PAIRS[2 * (rest % 100)];
+      begin[0] = pair[0];
+      begin[1] = pair[1];
+      rest /= 100;
+    }
+    if (rest >= 10) {
+      begin -= 2;
+      begin[0] = DIGIT_PAIRS[2 * rest];
+      begin[1] = DIGIT_PAIRS[2 * rest + 1];
+    } else {
+      *--begin = '0' + rest;
+    }
+  }
+  if (end - begin < width)
+    append_spaces(width - (end - begin));
+  buffer_.append(begin, end);
+}
+
+void TextFormatter::append(const Board& board) {
+  const int size = board.size();
+  const int width = value_width(size);
+  for (int row = 0; row < size; ++row) {
+    for (const int value : board.row(row)) {
+      append_number(value, width);
+      buffer_.push_back(' ');
+    }
+    buffer_.push_back('\n');
+  }
+}
+
+void TextFormatter::append(const Puzzle& puzzle) {
+  const int size = puzzle.size();
+  const int width = value_width(size);
+
+  append_spaces(width);
+  for (const int v : puzzle.top()) {
+    append_number(v, width);
+    buffer_.push_back(' ');
+  }
+  buffer_.push_back('\n');
+
+  for (int row = 0; row < size; ++row) {
+    append_number(puzzle.left()[row], width);
+    append_spaces((width + 1) * size - 1);
+    append_number(puzzle.right()[row], width);
+    buffer_.push_back('\n');
+  }
+
+  append_spaces(width);
+  for (const int v : puzzle.bottom()) {
+    append_number(v, width);
+    buffer_.push_back(' ');
+  }
+  buffer_.push_back('\n');
+}
+
+bool TextFormatter::write(std::ostream& ostream) {
+  ostream.write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  return ostream.good();
+}
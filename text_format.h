@@ -0,0 +1,59 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+class Board;
+class Puzzle;
+
+// Renders boards and puzzles in the text format of `Board::print()`
+// and `Puzzle::print()` into a growing buffer, which is reused after
+// each write. Numbers are converted with a table of digit pairs, and
+// nothing reaches the stream until `write()`, so a batch of puzzles
+// costs a single write call.
+class TextFormatter {
+ public:
+  // Appends a board, or a puzzle, with the same bytes as its print().
+  void append(const Board& board);
+  void append(const Puzzle& puzzle);
+
+  // Appends an empty line, as used between puzzles.
+  void append_newline() { buffer_.push_back('\n'); }
+
+  // How many bytes are waiting to be written.
+  size_t size() const { return buffer_.size(); }
+
+  // Writes the buffer to `ostream` and empties it. Returns whether the
+  // stream is still good.
+  bool write(std::ostream& ostream);
+
+ private:
+  // Appends `value`, right-aligned in `width` characters; wider values
+  // are not truncated.
+  void append_number(const int value, const int width);
+  void append_spaces(const int count) { buffer_.append(count, ' '); }
+
+  std::string buffer_;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+struct Span {
+  const char* name;
+  uint64_t start_ns;
+  uint64_t duration_ns;
+};
+
+// Spans are stored in fixed-size chunks, so that recording never
+// moves the ones already recorded. A thread keeps at most
+// MAX_CHUNKS_PER_THREAD of them, about 24 MiB, so that a long run
+// cannot exhaust memory; the spans past that are dropped and counted.
+constexpr int SPANS_PER_CHUNK = 4096;
+constexpr int MAX_CHUNKS_PER_THREAD = 256;
+
+struct Chunk {
+  Span spans[SPANS_PER_CHUNK];
+  // Written only by the owning thread; published with release.
+  std::atomic<int> count{0};
+  Chunk* next = nullptr;
+};
+
+// The spans of one thread. Buffers are never freed, since the trace
+// is written after the threads that own them may have exited.
+struct ThreadBuffer {
+  int thread_id;
+  Chunk* first;
+  Chunk* last;
+  ThreadBuffer* next;
+  // Written only by the owning thread.
+  int chunks = 1;
+  std::atomic<uint64_t> dropped{0};
+};
+
+std::chrono::steady_clock::time_point trace_start;
+FILE* trace_file = nullptr;
+std::atomic<ThreadBuffer*> buffers{nullptr};
+std::atomic<int> next_thread_id{0};
+thread_local ThreadBuffer* thread_buffer = nullptr;
+
+// Creates the buffer of the calling thread, and pushes it onto the
+// list of all buffers.
+ThreadBuffer* register_thread() {
+  Chunk* chunk = new Chunk;
+  ThreadBuffer* buffer = new ThreadBuffer{next_thread_id.fetch_add(1), chunk, chunk, nullptr};
+  buffer->next = buffers.load(std::memory_order_relaxed);
+  while (!buffers.compare_exchange_weak(buffer->next, buffer, std::memory_order_release,
+                                        std::memory_order_relaxed)) {}
+  return buffer;
+}
+
+void write_trace() {
+  // Avoid iostreams here: they may already be gone.
+  std::fprintf(trace_file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+  const char* separator = "\n";
+  uint64_t dropped = 0;
+  for (const ThreadBuffer* buffer = buffers.load(std::memory_order_acquire); buffer != nullptr;
+       buffer = buffer->next) {
+    std::fprintf(trace_file,
+                 "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                 "\"args\": {\"name\": \"thread %d\"}}",
+                 separator, buffer->thread_id, buffer->thread_id);
+    separator = ",\n";
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+    for (const Chunk* chunk = buffer->first; chunk != nullptr; chunk = chunk->next) {
+      const int count = chunk->count.load(std::memory_order_acquire);
+      for (int i = 0; i < count; ++i) {
+        const Span& span = chunk->spans[i];
+        // Timestamps are in microseconds.
+        std::fprintf(trace_file,
+                     "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                     "\"ts\": %.3f, \"dur\": %.3f}",
+                     separator, span.name, buffer->thread_id, span.start_ns / 1e3,
+                     span.duration_ns / 1e3);
+      }
+    }
+  }
+  std::fprintf(trace_file, "\n], \"otherData\": {\"dropped_spans\": %llu}}\n",
+               static_cast<unsigned long long>(dropped));
+  std::fclose(trace_file);
+  if (dropped > 0) {
+    std::fprintf(stderr, "WARNING: the trace dropped %llu spans past %d per thread\n",
+                 static_cast<unsigned long long>(dropped),
+                 SPANS_PER_CHUNK * MAX_CHUNKS_PER_THREAD);
+  }
+}
+
+}  // namespace
+
+namespace trace_internal {
+
+std::atomic<bool> enabled{false};
+
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - trace_start).count();
+}
+
+void record(const char* name, const uint64_t start_ns) {
+  const uint64_t end_ns = now_ns();
+  if (thread_buffer == nullptr)
+    thread_buffer = register_thread();
+  Chunk* chunk = thread_buffer->last;
+  int count = chunk->count.load(std::memory_order_relaxed);
+  if (count == SPANS_PER_CHUNK) {
+    if (thread_buffer->chunks == MAX_CHUNKS_PER_THREAD) {
+      thread_buffer->dropped.store(thread_buffer->dropped.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+      return;
+    }
+    ++thread_buffer->chunks;
+    chunk->next = new Chunk;
+    chunk = thread_buffer->last = chunk->next;
+    count = 0;
+  }
+  chunk->spans[count] = Span{name, start_ns, end_ns - start_ns};
+  chunk->count.store(count + 1, std::memory_order_release);
+}
+
+}  // namespace trace_internal
+
+bool start_trace(const char* path) {
+  trace_file = std::fopen(path, "w");
+  if (trace_file == nullptr) {
+    std::cerr << "ERROR: cannot write the trace to " << path << std::endl;
+    return false;
+  }
+  trace_start = std::chrono::steady_clock::now();
+  std::atexit(write_trace);
+  trace_internal::enabled.store(true);
+  return true;
+}
@@ -0,0 +1,70 @@
+/*
+ *  Generate and solve skyscraper puzzles
+ *  Copyright (C) 2024  Marco Leogrande
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+
+// Phase timelines, enabled at run time with --trace. Each thread
+// records the spans of its TraceScope objects into its own buffer,
+// without locks, and on exit all of them are written as Chrome
+// trace-event JSON, which trace viewers such as Perfetto load. Each
+// buffer is capped; the spans that do not fit are only counted, and
+// the count is written with the trace. While tracing is off, a scope
+// costs one relaxed load.
+
+// Starts recording, and arranges for the trace to be written to
+// `path` on exit. Returns false if the file cannot be created.
+bool start_trace(const char* path);
+
+namespace trace_internal {
+
+extern std::atomic<bool> enabled;
+
+// Nanoseconds since tracing started.
+uint64_t now_ns();
+
+// Appends a span to the buffer of the calling thread.
+void record(const char* name, const uint64_t start_ns);
+
+}  // namespace trace_internal
+
+// Records a span named `name` (a string literal) from construction
+// to destruction, if tracing is on.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name)
+    : name_(trace_internal::enabled.load(std::memory_order_relaxed) ? name : nullptr),
+      start_ns_(name_ != nullptr ? trace_internal::now_ns() : 0) {}
+
+  ~TraceScope() {
+    if (name_ != nullptr)
+      trace_internal::record(name_, start_ns_);
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* const name_;
+  const uint64_t start_ns_;
+};
+
+#endif